@@ -0,0 +1,46 @@
+#ifndef _ANIMATION_H
+#define _ANIMATION_H
+
+#include <vector>
+
+#include "tree.h"
+
+// Animacao dos nodos ate a posicao do layout. Os dados ficam em vetores
+// separados (SoA) para que o passo de cada quadro seja um laco simples,
+// vetorizado com SSE quando disponivel. O movimento depende do tempo, nao
+// do numero de quadros: cada nodo leva "duracao" segundos, com suavizacao
+// (smoothstep) na saida e na chegada.
+struct TAnimacao
+{
+    std::vector<pNodoA*> nodos;
+    std::vector<float> x0, y0;   // posicao de partida
+    std::vector<float> dx, dy;   // destino - partida
+    std::vector<float> t;        // progresso em [0, 1]
+    std::vector<float> x, y;     // posicao atual
+    float duracao;               // segundos
+    bool parado;                 // todos os nodos chegaram
+    unsigned long geracao;       // GeracaoArvore() quando os nodos foram lidos
+};
+
+void IniciaAnimacao(TAnimacao* a, float duracao);
+
+// Recomeca depois de um novo layout: cada nodo sai de (currX, currY) em
+// direcao a (x, y). Nodos ja no lugar nao se movem. O(n).
+void AnimaArvore(TAnimacao* a, pNodoA* raiz);
+
+// Avanca dt segundos e atualiza currX e currY dos nodos.
+// Quando tudo esta parado custa O(1). Retorna "parado". Se a arvore mudou
+// desde AnimaArvore(), nada e' escrito ate a proxima chamada dela.
+bool AvancaAnimacao(TAnimacao* a, float dt);
+
+// Como AvancaAnimacao, mas poe todos os nodos no ponto "decorrido" segundos
+// apos AnimaArvore(). E' o que o vertex shader calcula quando a animacao
+// roda na GPU; usado para trazer currX/currY para a CPU quando necessario.
+bool PosicionaAnimacao(TAnimacao* a, float decorrido);
+
+// Posicao, "decorrido" segundos apos AnimaArvore(), do i-esimo nodo (na
+// pre-ordem da arvore passada a ela), sem escrever nada nos nodos. O(1);
+// serve para consultar poucos nodos quando a animacao roda na GPU.
+void PosicaoAnimacao(const TAnimacao* a, size_t i, float decorrido, float* x, float* y);
+
+#endif // _ANIMATION_H
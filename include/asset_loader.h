@@ -0,0 +1,69 @@
+#ifndef _ASSET_LOADER_H
+#define _ASSET_LOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Carga de recursos em paralelo. Cada carga tem duas partes: "trabalho"
+// (ler arquivo, decodificar, calcular normais...), que roda numa thread do
+// pool, e "envio" (chamadas OpenGL), que roda na thread do contexto quando
+// ela chama TrataCargasProntas(). Quando a ultima carga agendada termina o
+// envio, o callback de "tudo pronto" e' chamado, tambem nessa thread.
+
+typedef void (*CargasProntasCallback)();
+
+struct TCarga
+{
+    std::string           nome;
+    std::function<void()> trabalho;
+    std::function<void()> envio;     // pode ser vazio
+    double agendada;   // segundos desde IniciaCarregador()
+    double inicio;     // trabalho comecou
+    double fimTrabalho;
+    double inicioEnvio;
+    double fimEnvio;
+};
+
+struct TCarregador
+{
+    std::vector<std::thread> threads;
+    std::vector<TCarga*>     cargas;    // todas, na ordem em que foram agendadas
+
+    std::mutex               trava;
+    std::condition_variable  temTrabalho;
+    std::deque<TCarga*>      pendentes; // esperando uma thread
+    std::deque<TCarga*>      prontas;   // trabalho feito, esperando o envio
+    bool                     encerrando;
+
+    size_t                   enviadas;
+    CargasProntasCallback    aoTerminar;
+    double                   relogio0;
+};
+
+// numThreads <= 0: uma por nucleo.
+void IniciaCarregador(TCarregador* c, int numThreads);
+
+void AgendaCarga(TCarregador* c, const char* nome,
+                 std::function<void()> trabalho, std::function<void()> envio);
+
+// Chamado uma vez, quando todas as cargas agendadas ate' entao terminarem.
+void DefineCallbackCargasProntas(TCarregador* c, CargasProntasCallback callback);
+
+// Thread do OpenGL: faz o envio das cargas cujo trabalho terminou. Devolve
+// quantas foram enviadas.
+int TrataCargasProntas(TCarregador* c);
+
+bool CargasTerminadas(TCarregador* c);
+
+// Tempo de cada carga: espera na fila, trabalho, espera pelo envio e envio.
+void ImprimeRelatorioCargas(TCarregador* c);
+
+// Espera as threads terminarem e libera as cargas.
+void EncerraCarregador(TCarregador* c);
+
+#endif // _ASSET_LOADER_H
@@ -0,0 +1,49 @@
+#ifndef _COMPACT_TREE_H
+#define _COMPACT_TREE_H
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+
+#include "tree.h"
+
+#define NODO_NULO 0xFFFFFFFFu
+
+// Nodo compacto: so o que a busca precisa (12 bytes). Os filhos sao indices
+// em TArvoreCompacta::nodos.
+struct TNodoC
+{
+    int      info;
+    uint32_t esq;
+    uint32_t dir;
+};
+
+// Arvore com nodos em um unico vetor, separados em parte "quente" (chave e
+// filhos) e "fria" (coordenadas de desenho, em float, em vetores a parte).
+// O nodo de indice i tem coordenadas (x[i], y[i]).
+struct TArvoreCompacta
+{
+    std::vector<TNodoC> nodos;
+    std::vector<float>  x;
+    std::vector<float>  y;
+    uint32_t raiz;
+    uint32_t livres; // indices removidos, encadeados por "esq"
+};
+
+void IniciaArvoreCompacta(TArvoreCompacta* c);
+
+// Copia a arvore "a" (chaves e posicao x/y) para "c", em pre-ordem: o filho
+// da esquerda fica logo apos o pai no vetor.
+void CompactaArvore(pNodoA* a, TArvoreCompacta* c);
+
+// Insercao e remocao de ABP, sem balanceamento: a forma vem da arvore
+// compactada. Retornam o indice do nodo (ou NODO_NULO).
+uint32_t InsereCompacta(TArvoreCompacta* c, int ch);
+void RemoveCompacta(TArvoreCompacta* c, int ch);
+
+uint32_t consultaCompacta(const TArvoreCompacta* c, int chave);
+
+// Bytes reservados pelos vetores da arvore.
+size_t MemoriaCompacta(const TArvoreCompacta* c);
+
+#endif // _COMPACT_TREE_H
@@ -0,0 +1,25 @@
+#ifndef _EYTZINGER_H
+#define _EYTZINGER_H
+
+#include <vector>
+
+#include "tree.h"
+
+// Copia imutavel de uma arvore em layout de Eytzinger (ordem de nivel de uma
+// arvore completa, como num heap): os filhos de k estao em 2k e 2k+1. A
+// busca so percorre um vetor de int, sem seguir ponteiros.
+struct TArvoreEytzinger
+{
+    std::vector<int>     chaves; // 1..n; chaves[0] nao e' usado
+    std::vector<pNodoA*> nodos;  // nodo original de cada chave
+    int n;
+};
+
+// Congela as chaves atuais de "a". A copia fica invalida (mas ainda
+// consultavel) assim que a arvore original muda.
+void CongelaArvore(pNodoA* a, TArvoreEytzinger* e);
+
+// Mesmo contrato de consultaABP: o nodo com a chave, ou NULL.
+pNodoA* consultaEytzinger(const TArvoreEytzinger* e, int chave);
+
+#endif // _EYTZINGER_H
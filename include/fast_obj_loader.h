@@ -0,0 +1,24 @@
+#ifndef _FAST_OBJ_LOADER_H
+#define _FAST_OBJ_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+
+// Leitura rapida de OBJ: o arquivo e' mapeado em memoria, dividido em
+// pedacos (em fins de linha) lidos em paralelo, e os pedacos sao juntados no
+// fim. O resultado e' o mesmo de tinyobj::LoadObj() com triangulacao
+// (v, vn, vt, f, g, o; indices negativos incluidos).
+//
+// Materiais e tags de subdivisao nao sao lidos: se o arquivo tiver "mtllib"
+// ou "t", devolve falso sem mexer na saida, e quem chamou deve usar
+// tinyobj::LoadObj(). Tambem devolve falso se o arquivo nao puder ser lido.
+bool LeObjRapido(const char* caminho, tinyobj::attrib_t* attrib,
+                 std::vector<tinyobj::shape_t>* shapes, int numThreads = 0);
+
+// Converte o numero no inicio de "s" (ate' "fim"), no formato do OBJ:
+// sinal, digitos, ponto, expoente. Avanca "s" ate' o fim do numero.
+double LeNumeroObj(const char** s, const char* fim);
+
+#endif // _FAST_OBJ_LOADER_H
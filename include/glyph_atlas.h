@@ -0,0 +1,23 @@
+#ifndef _GLYPH_ATLAS_H
+#define _GLYPH_ATLAS_H
+
+#include <vector>
+
+// Atlas de campo de distancia (SDF) com os glifos "0123456789-", lado a
+// lado numa unica linha. Os glifos sao gerados a partir de tracos (linhas e
+// arcos), sem depender de fonte em disco. Cada texel guarda 0.5 na borda
+// do traco, mais perto de 1 por dentro e de 0 por fora, entao o shader
+// desenha o texto nitido em qualquer escala com um smoothstep.
+#define ATLAS_GLIFOS        11
+#define ATLAS_GLIFO_MENOS   10 // indice do '-'
+#define ATLAS_GLIFO_LARGURA 32 // pixels
+#define ATLAS_GLIFO_ALTURA  48
+
+// Preenche "pixels" (um byte por texel, linha a linha, de baixo para cima
+// como espera o OpenGL) com ATLAS_GLIFOS*ATLAS_GLIFO_LARGURA x ATLAS_GLIFO_ALTURA texels.
+void GeraAtlasGlifos(std::vector<unsigned char>& pixels);
+
+// Indice no atlas do caractere c ('0'..'9' ou '-'); -1 se nao houver.
+int GlifoAtlas(char c);
+
+#endif // _GLYPH_ATLAS_H
@@ -0,0 +1,23 @@
+#ifndef _MAPPED_FILE_H
+#define _MAPPED_FILE_H
+
+#include <cstddef>
+
+// Arquivo inteiro em memoria, somente leitura: mmap onde houver, senao
+// (_WIN32) lido com fread para um buffer.
+struct TArquivoMapeado
+{
+    const char* dados;
+    size_t      tamanho;
+    bool        mapeado; // falso: "dados" veio de malloc
+};
+
+// Falso se o arquivo nao existe ou nao pode ser lido.
+bool MapeiaArquivo(const char* caminho, TArquivoMapeado* arquivo);
+void DesmapeiaArquivo(TArquivoMapeado* arquivo);
+
+// Hash de 64 bits do conteudo (FNV-1a em palavras de 8 bytes). Nao e'
+// criptografico: so' detecta que o arquivo mudou.
+unsigned long long HashDados(const char* dados, size_t tamanho);
+
+#endif // _MAPPED_FILE_H
@@ -0,0 +1,72 @@
+#ifndef _MESH_CACHE_H
+#define _MESH_CACHE_H
+
+#include <string>
+#include <vector>
+
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "mapped_file.h"
+
+// Cache binaria das malhas ja' prontas para a GPU (depois da leitura do OBJ,
+// das normais, de OtimizaMalha() e de GeraNiveisLod()), para nao refazer
+// tudo a cada execucao.
+// O arquivo guarda o hash do OBJ de origem e uma versao do formato; se
+// qualquer um nao bater, a cache e' ignorada e refeita.
+//
+// Formato (little-endian, tudo alinhado em 4 bytes):
+//   cabecalho: "TVMC", versao, hash da fonte (8 bytes), numero de objetos
+//   por objeto: tamanho do nome, nome (completado ate' multiplo de 4),
+//               bbox min e max (6 floats), vertices, indices, atributos,
+//               numero de niveis, niveis (TNivelLod: primeiro, quantos, erro),
+//               posicoes (4 floats/vertice), normais (4), texcoords (2),
+//               indices (de todos os niveis)
+
+#define VERSAO_CACHE_MALHAS 2
+
+// Atributos presentes num objeto cozido
+#define COZIDO_NORMAIS   1
+#define COZIDO_TEXCOORDS 2
+
+// Objeto pronto para a GPU, como produzido ao ler um OBJ.
+struct TObjetoCozido
+{
+    std::string nome;
+    TMalha      malha;      // indices de todos os niveis de detalhe
+    std::vector<TNivelLod> niveis;
+    float       bboxMin[3];
+    float       bboxMax[3];
+};
+
+// O mesmo, apontando para dentro de um arquivo de cache mapeado.
+struct TVistaCozida
+{
+    const char*         nome;
+    unsigned int        tamanhoNome;
+    float               bboxMin[3];
+    float               bboxMax[3];
+    unsigned int        numVertices;
+    unsigned int        numIndices;
+    unsigned int        numNiveis;
+    const TNivelLod*    niveis;
+    const float*        posicoes;
+    const float*        normais;   // NULL se o objeto nao tem
+    const float*        texcoords; // NULL se o objeto nao tem
+    const unsigned int* indices;
+};
+
+struct TCacheMalhas
+{
+    TArquivoMapeado           arquivo;
+    std::vector<TVistaCozida> objetos;
+};
+
+// Abre a cache se ela existir, for desta versao e tiver sido feita a partir
+// de uma fonte com "hashFonte". As vistas valem ate' FechaCacheMalhas().
+bool AbreCacheMalhas(const char* caminho, unsigned long long hashFonte, TCacheMalhas* cache);
+void FechaCacheMalhas(TCacheMalhas* cache);
+
+bool GravaCacheMalhas(const char* caminho, unsigned long long hashFonte,
+                      const std::vector<TObjetoCozido>& objetos);
+
+#endif // _MESH_CACHE_H
@@ -0,0 +1,50 @@
+#ifndef _MESH_OPTIMIZER_H
+#define _MESH_OPTIMIZER_H
+
+#include <vector>
+#include <cstddef>
+
+// Malha de triangulos na CPU, no formato dos atributos de "shader_vertex.glsl":
+// posicoes e normais com 4 floats por vertice, coordenadas de textura com 2.
+// "normais" e "texcoords" podem estar vazios.
+struct TMalha
+{
+    std::vector<float>        posicoes;
+    std::vector<float>        normais;
+    std::vector<float>        texcoords;
+    std::vector<unsigned int> indices;
+};
+
+// Tamanho da cache de vertices (FIFO) suposta pela otimizacao e pelo ACMR.
+#define TAMANHO_CACHE_VERTICES 16
+
+inline size_t NumVerticesMalha(const TMalha& m) { return m.posicoes.size() / 4; }
+
+// Junta vertices com posicao, normal e coordenada de textura identicas,
+// refazendo os indices. Devolve o novo numero de vertices.
+size_t SoldaVertices(TMalha* m);
+
+// Reordena os triangulos para reaproveitar a cache de vertices (Tipsify,
+// Sander, Nehab e Barczak, 2007). Linear no numero de indices.
+void OtimizaCacheVertices(TMalha* m, int tamanhoCache);
+
+// Renumera os vertices na ordem em que os indices os usam pela primeira vez,
+// para que a busca dos atributos ande para frente na memoria.
+void OtimizaBuscaVertices(TMalha* m);
+
+// Media de vertices transformados por triangulo (ACMR) com uma cache FIFO
+// de "tamanhoCache" entradas: 3 sem reuso nenhum, perto de 0.5 no melhor caso.
+double CalculaACMR(const std::vector<unsigned int>& indices, size_t numVertices, int tamanhoCache);
+
+struct TRelatorioMalha
+{
+    size_t verticesAntes;  // sem solda: um por indice
+    size_t verticesDepois;
+    double acmrSoldada;    // depois da solda, na ordem original dos triangulos
+    double acmrOtimizada;  // depois da reordenacao
+};
+
+// Solda, reordena os triangulos e depois os vertices.
+TRelatorioMalha OtimizaMalha(TMalha* m);
+
+#endif // _MESH_OPTIMIZER_H
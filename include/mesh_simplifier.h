@@ -0,0 +1,39 @@
+#ifndef _MESH_SIMPLIFIER_H
+#define _MESH_SIMPLIFIER_H
+
+#include <vector>
+#include <cstddef>
+
+#include "mesh_optimizer.h"
+
+// Niveis de detalhe (LOD) de uma malha. Todos os niveis usam os mesmos
+// vertices; cada um e' um trecho de indices proprio, e o nivel 0 e' a malha
+// original. "erro" e' o quanto a superficie do nivel se afasta da original,
+// em unidades do modelo (raiz do erro quadratico medio dos planos).
+struct TNivelLod
+{
+    unsigned int primeiroIndice;
+    unsigned int numIndices;
+    float        erro;
+};
+
+#define MAX_NIVEIS_LOD 8
+
+// Abaixo disso nao vale um nivel a mais.
+#define MIN_TRIANGULOS_LOD 32
+
+// Simplifica os triangulos "indices" (sobre os vertices de "m") por colapso
+// de arestas com erro quadratico (Garland e Heckbert, 1997) ate' no maximo
+// "numIndicesAlvo" indices, ou ate' nao haver mais colapso possivel. Um
+// vertice colapsa sempre sobre um vizinho existente, entao nenhum vertice
+// novo e' criado. Vertices de borda e de costura (mesma posicao com normal
+// ou textura diferentes) ficam fixos. Devolve o erro do resultado.
+float SimplificaMalha(const TMalha& m, const std::vector<unsigned int>& indices,
+                      size_t numIndicesAlvo, std::vector<unsigned int>* saida);
+
+// Acrescenta a m->indices os niveis 1, 2... (cada um com cerca de metade
+// dos triangulos do anterior, simplificado a partir do original e
+// reordenado para a cache de vertices) e descreve todos em "niveis".
+void GeraNiveisLod(TMalha* m, std::vector<TNivelLod>* niveis);
+
+#endif // _MESH_SIMPLIFIER_H
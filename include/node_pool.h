@@ -0,0 +1,46 @@
+#ifndef _NODE_POOL_H
+#define _NODE_POOL_H
+
+#include <cstddef>
+#include <vector>
+
+#include "tree.h"
+
+// Numero de nodos alocados de uma so vez a cada novo slab.
+#define POOL_NODOS_POR_SLAB 1024
+
+// Arena de TNodoA: os nodos sao entregues em sequencia a partir de slabs
+// contiguos, e os nodos liberados vao para uma lista encadeada (por "esq")
+// para serem reaproveitados antes de se pegar memoria nova.
+struct TPoolNodos
+{
+    std::vector<pNodoA*> slabs; // blocos de POOL_NODOS_POR_SLAB nodos
+    size_t  slabAtual;          // slab de onde sai o proximo nodo nunca usado
+    size_t  usadosSlab;         // nodos ja entregues do slab atual
+    pNodoA* livres;             // nodos devolvidos por LiberaNodo()
+    size_t  vivos;              // nodos entregues e ainda nao devolvidos
+};
+
+struct TEstatisticasPool
+{
+    size_t vivos;      // nodos em uso
+    size_t reservados; // capacidade total dos slabs
+    size_t livres;     // nodos na lista de reaproveitamento
+    size_t slabs;
+};
+
+void IniciaPool(TPoolNodos* pool);
+pNodoA* AlocaNodo(TPoolNodos* pool);
+void LiberaNodo(TPoolNodos* pool, pNodoA* nodo);
+
+// Devolve todos os nodos de uma vez, em O(1). Os slabs continuam reservados
+// e sao reaproveitados pelas proximas alocacoes. Como LiberaArvore, avanca
+// GeracaoArvore().
+void EsvaziaPool(TPoolNodos* pool);
+
+// Devolve os slabs ao sistema (e tambem avanca GeracaoArvore()).
+void DestroiPool(TPoolNodos* pool);
+
+TEstatisticasPool EstatisticasPool(const TPoolNodos* pool);
+
+#endif // _NODE_POOL_H
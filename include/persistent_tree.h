@@ -0,0 +1,57 @@
+#ifndef _PERSISTENT_TREE_H
+#define _PERSISTENT_TREE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "tree.h"
+#include "node_pool.h"
+
+// Arvore persistente: inserir ou remover nao altera a arvore recebida. So
+// os nodos do caminho ate a chave (e os das rotacoes) sao copiados; o resto
+// e' compartilhado com a versao anterior. Cada operacao custa O(log n)
+// nodos novos, e toda versao continua valida.
+//
+// As versoes sao sempre AVL, independente de DefineModoArvore(). Como os
+// nodos sao compartilhados, nao podem ser liberados um a um: todos vem do
+// pool passado e sao devolvidos juntos com EsvaziaPool/DestroiPool.
+//
+// Pelo mesmo motivo as versoes sao so' de leitura (const), inclusive o
+// estado de layout e animacao dos nodos (x, y, currX, currY, sujo): um
+// nodo desenhado numa versao mudaria de lugar em todas as outras. Para
+// desenhar uma versao, use CopiaVersao(), que custa O(n); e' o que o
+// visualizador faz ao desfazer (U) e refazer (R). Enquanto isso, novas
+// versoes podem ser criadas sem tocar na copia desenhada.
+const pNodoA* InserePersistente(TPoolNodos* pool, const pNodoA* raiz, int ch);
+const pNodoA* RemovePersistente(TPoolNodos* pool, const pNodoA* raiz, int ch);
+
+// Copia inteira de uma versao, em O(n) nodos tirados de "pool", sem nada
+// compartilhado: pode ser posicionada e animada como qualquer arvore. Com
+// pool = PoolArvore(), e' liberada com LiberaArvore().
+pNodoA* CopiaVersao(TPoolNodos* pool, const pNodoA* versao);
+
+// Sequencia de versoes, com desfazer/refazer.
+struct THistoricoArvore
+{
+    std::vector<const pNodoA*> versoes; // versoes[0] e' a arvore vazia
+    size_t atual;                 // indice da versao em uso
+    TPoolNodos pool;              // nodos de todas as versoes
+};
+
+void IniciaHistorico(THistoricoArvore* h);
+void DestroiHistorico(THistoricoArvore* h);
+
+// Cria uma nova versao a partir da atual. As versoes "refaziveis" depois
+// da atual sao descartadas (seus nodos so voltam no DestroiHistorico). Se
+// nada muda (chave repetida ou ausente), nenhuma versao e' criada.
+const pNodoA* HistoricoInsere(THistoricoArvore* h, int ch);
+const pNodoA* HistoricoRemove(THistoricoArvore* h, int ch);
+
+const pNodoA* VersaoAtual(const THistoricoArvore* h);
+const pNodoA* Versao(const THistoricoArvore* h, size_t i);
+
+// Movem a versao atual; retornam false se nao ha para onde ir.
+bool Desfaz(THistoricoArvore* h);
+bool Refaz(THistoricoArvore* h);
+
+#endif // _PERSISTENT_TREE_H
@@ -0,0 +1,74 @@
+#ifndef _RENDER_QUEUE_H
+#define _RENDER_QUEUE_H
+
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// Fila de desenho: quem desenha so' submete itens durante o quadro; no fim,
+// ExecutaFilaDesenho() ordena os itens pela chave (programa, VAO, textura,
+// object_id) e so' manda para a GPU o estado que mudou de um item para o
+// seguinte. Itens com "mistura" vao depois de todos os opacos, na ordem em
+// que foram submetidos. Itens seguidos com o mesmo estado, sem instancias,
+// viram um so' glMultiDrawElementsBaseVertex.
+
+struct TItemDesenho
+{
+    GLuint    programa;
+    GLuint    vao;
+    GLuint    textura;        // 0: nenhuma textura a ligar
+    GLenum    unidadeTextura; // unidade onde "textura" e' ligada (GL_TEXTURE0 + i)
+    GLint     objeto;         // valor de "object_id"
+    bool      instanciado;    // valor de "nodos_instanciados"
+    bool      mistura;        // blending ligado e culling desligado
+    GLenum    modo;           // GL_TRIANGLES, GL_LINES, ...
+    GLsizei   numIndices;
+    size_t    primeiroIndice; // em indices, nao em bytes
+    GLint     verticeBase;
+    GLsizei   instancias;     // 0: glDrawElements, senao glDrawElementsInstanced
+    glm::mat4 modelo;
+    glm::vec3 bboxMin;
+    glm::vec3 bboxMax;
+};
+
+// Mudancas de estado do ultimo ExecutaFilaDesenho(): "emitidas" foram de
+// fato para a GPU, "puladas" eram iguais ao estado ja ligado.
+struct TEstatisticasFila
+{
+    int itens;
+    int desenhos; // chamadas de desenho; menos que "itens" quando agrupados
+    int emitidas;
+    int puladas;
+};
+
+struct TFilaDesenho
+{
+    std::vector<TItemDesenho> itens;
+    std::vector<unsigned long long> chaves; // chave << 24 | indice do item
+    std::vector<GLsizei> contagens;         // de um glMultiDrawElementsBaseVertex
+    std::vector<const void*> deslocamentos;
+    std::vector<GLint> verticesBase;
+    TEstatisticasFila estatisticas;
+
+    // Locais dos uniforms escritos pela fila; iguais em todos os programas.
+    GLint uniformModelo;
+    GLint uniformObjeto;
+    GLint uniformInstanciado;
+    GLint uniformBboxMin;
+    GLint uniformBboxMax;
+};
+
+// Item com o estado padrao: sem textura, sem instancias, sem mistura,
+// vertice base 0.
+TItemDesenho ItemDesenho(GLuint programa, GLuint vao, GLint objeto, GLenum modo,
+                         GLsizei numIndices, size_t primeiroIndice, const glm::mat4& modelo);
+
+void SubmeteDesenho(TFilaDesenho* f, const TItemDesenho& item);
+
+// Desenha e esvazia a fila. Ao final, o VAO 0 fica ligado e blending e
+// culling voltam ao padrao (desligado e ligado).
+void ExecutaFilaDesenho(TFilaDesenho* f);
+
+#endif // _RENDER_QUEUE_H
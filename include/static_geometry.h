@@ -0,0 +1,49 @@
+#ifndef _STATIC_GEOMETRY_H
+#define _STATIC_GEOMETRY_H
+
+#include <vector>
+#include <cstddef>
+
+#include <glad/glad.h>
+
+// Todas as malhas estaticas da cena num so' conjunto de buffers (posicoes,
+// normais, coordenadas de textura e indices) sob um unico VAO. Cada malha e'
+// um trecho: seus indices comecam em "primeiroIndice" e sao relativos ao seu
+// primeiro vertice, "verticeBase" (glDrawElementsBaseVertex).
+
+struct TTrechoGeometria
+{
+    size_t primeiroIndice;
+    size_t numIndices;
+    GLint  verticeBase;
+};
+
+struct TGeometriaEstatica
+{
+    // Copia na CPU, acumulada ate' EnviaGeometriaEstatica().
+    std::vector<float>  posicoes;  // 4 por vertice, "(location = 0)"
+    std::vector<float>  normais;   // 4 por vertice, "(location = 1)"
+    std::vector<float>  texcoords; // 2 por vertice, "(location = 2)"
+    std::vector<GLuint> indices;
+
+    GLuint vao;
+    GLuint buffers[4]; // posicoes, normais, texcoords, indices
+};
+
+// Cria o VAO e os buffers (vazios). O VAO ja' pode ser guardado nos objetos
+// da cena antes do envio.
+void IniciaGeometriaEstatica(TGeometriaEstatica* g);
+
+// Acrescenta uma malha; "normais" e "texcoords" podem ser NULL (zeros).
+TTrechoGeometria AcrescentaMalha(TGeometriaEstatica* g,
+                                 const float* posicoes, const float* normais, const float* texcoords,
+                                 size_t numVertices, const GLuint* indices, size_t numIndices);
+
+// Envia tudo o que foi acrescentado para a GPU e libera a copia na CPU.
+void EnviaGeometriaEstatica(TGeometriaEstatica* g);
+
+// Outro VAO sobre os mesmos buffers, para quem precisa de atributos a mais
+// (por instancia, por exemplo) sem mexer no VAO compartilhado.
+GLuint CriaVaoGeometria(const TGeometriaEstatica* g);
+
+#endif // _STATIC_GEOMETRY_H
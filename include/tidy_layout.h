@@ -0,0 +1,16 @@
+#ifndef _TIDY_LAYOUT_H
+#define _TIDY_LAYOUT_H
+
+#include "tree.h"
+
+// Layout "arrumado" de Reingold-Tilford: cada subarvore ocupa so a largura
+// que realmente precisa, e dois nodos do mesmo nivel ficam a pelo menos
+// "separacao" pixels um do outro, qualquer que seja a profundidade. Os
+// filhos ficam simetricos sob o pai; um filho unico fica meio passo para o
+// seu lado. A arvore e' centrada em largura/2 e pode passar da largura dada;
+// os niveis dividem a altura, mas nunca ficam a menos de "separacao".
+//
+// Preenche x, y e level de todos os nodos em O(n), sem recursao.
+void LayoutArrumado(pNodoA* raiz, double largura, double altura, double separacao);
+
+#endif // _TIDY_LAYOUT_H
@@ -1,27 +1,129 @@
+#ifndef _TREE_H
+#define _TREE_H
+
 #include<iostream>
 #include<math.h>
+#include<vector>
+
+// Modos de balanceamento suportados por InsereArvore/RemoveArvore
+#define ARVORE_ABP 0 // arvore binaria de pesquisa simples, sem balanceamento
+#define ARVORE_AVL 1
+#define ARVORE_RN  2 // rubro-negra (left-leaning red-black)
+
 struct TNodoA{
         int info;
         double x;
 	    double y;
         double currX = 0;
 	    double currY = 0;
-        bool emPosicao = false;
         struct TNodoA *esq;
         struct TNodoA *dir;
         int level;
         int col;
+        int altura;     // altura da subarvore
+        int tamanho;    // numero de nodos da subarvore
+        bool vermelho;  // cor do nodo (rubro-negra)
+        bool sujo;      // o nodo ou algum descendente mudou desde o ultimo layout
 
 };
 typedef struct TNodoA pNodoA;
 
+struct TPoolNodos; // node_pool.h
+
+// Chamada a cada rotacao: "antigaRaiz" desce e "novaRaiz" sobe para o lugar dela.
+typedef void (*RotacaoCallback)(pNodoA* antigaRaiz, pNodoA* novaRaiz);
+
+void DefineModoArvore(int modo);
+int ModoArvore();
+void DefineCallbackRotacao(RotacaoCallback callback);
+
+// Contador incrementado a cada insercao, remocao ou reconstrucao. Quem guarda
+// algo derivado da arvore (o layout, por exemplo) so precisa refazer quando
+// ele muda; os nodos alterados ficam marcados com "sujo".
+unsigned long GeracaoArvore();
+// Para quem libera nodos por fora das funcoes abaixo (EsvaziaPool, por exemplo).
+void AvancaGeracaoArvore();
+
+// Pool de onde InsereArvore tira os nodos (e para onde RemoveArvore os devolve).
+// Por padrao, um pool interno e' usado.
+void DefinePoolArvore(TPoolNodos* pool);
+TPoolNodos* PoolArvore();
+
 pNodoA* InsereArvore(pNodoA *a, int ch);
 
 
 pNodoA* consultaABP(pNodoA *a, int chave);
+// Busca n chaves de uma vez: resultados[i] = consultaABP(a, chaves[i]).
+// As buscas sao intercaladas para que as faltas de cache se sobreponham.
+void consultaABPBatch(pNodoA *a, const int* chaves, int n, pNodoA** resultados);
 pNodoA* minValor(pNodoA* node);
-  
+
 
 pNodoA* RemoveArvore(pNodoA *a, int ch);
 
-int getLevel(pNodoA* currNode);
\ No newline at end of file
+// Monta em O(n) uma arvore balanceada (valida no modo atual) com as chaves
+// dadas; repetidas sao ignoradas. Se "ordenadas" for falso as chaves sao
+// ordenadas antes, em paralelo se "ordenacaoParalela" for verdadeiro.
+pNodoA* ConstroiArvore(const int* chaves, int n, bool ordenadas, bool ordenacaoParalela);
+
+// Reconstroi a arvore no modo de balanceamento atual, preservando a posicao na tela dos nodos.
+pNodoA* ReconstroiArvore(pNodoA *a);
+
+// Leituras O(1): altura e tamanho sao mantidos a cada insercao/remocao.
+int alturaArvore(pNodoA* a);
+int tamanhoArvore(pNodoA* a);
+int fatorBalanceamento(pNodoA* a); // altura(esq) - altura(dir)
+
+/* Estatisticas de ordem, em O(log n) usando o tamanho das subarvores */
+
+// Quantas chaves sao menores que "ch" (posicao de "ch" em ordem, se existir).
+int rankArvore(pNodoA* a, int ch);
+// k-esima menor chave, a partir de 0; NULL se k estiver fora de [0, tamanho).
+pNodoA* selecionaArvore(pNodoA* a, int k);
+// Quantas chaves estao em [lo, hi].
+int contaIntervalo(pNodoA* a, int lo, int hi);
+
+// Devolve todos os nodos da arvore ao pool, um a um. Para apagar todas as
+// arvores de um pool de uma vez, use EsvaziaPool().
+void LiberaArvore(pNodoA *a);
+
+int getLevel(pNodoA* currNode);
+
+/* Percursos iterativos */
+
+#define PERCURSO_PRE   0
+#define PERCURSO_EM    1
+#define PERCURSO_POS   2
+#define PERCURSO_NIVEL 3
+
+// Percurso com pilha explicita (ou fila, em nivel), sem recursao: a
+// profundidade da arvore nao ameaca a pilha do processo. Guarde o TPercurso
+// entre usos para reaproveitar a memoria ja reservada.
+struct TPercurso
+{
+    std::vector<pNodoA*> pilha; // fila, no percurso em nivel
+    size_t  inicioFila;
+    int     ordem;
+    pNodoA* atual;     // em-ordem e pos-ordem: proximo nodo a descer
+    pNodoA* anterior;  // pre-ordem: filhos ainda nao empilhados; pos-ordem: ultimo visitado
+};
+
+void IniciaPercurso(TPercurso* p, pNodoA* raiz, int ordem);
+
+// Proximo nodo na ordem escolhida, ou NULL no fim.
+pNodoA* ProximoNodo(TPercurso* p);
+
+// Pre-ordem: nao visita os descendentes do ultimo nodo retornado.
+void PulaFilhos(TPercurso* p);
+
+// Percurso em ordem restrito as chaves em [lo, hi]: O(log n + k) para k chaves.
+struct TIntervalo
+{
+    std::vector<pNodoA*> pilha;
+    int hi;
+};
+
+void IniciaIntervalo(TIntervalo* it, pNodoA* raiz, int lo, int hi);
+pNodoA* ProximoIntervalo(TIntervalo* it);
+
+#endif // _TREE_H
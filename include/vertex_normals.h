@@ -0,0 +1,22 @@
+#ifndef _VERTEX_NORMALS_H
+#define _VERTEX_NORMALS_H
+
+#include <cstddef>
+#include <vector>
+
+// Normais por vertice (Gouraud): a normal de cada vertice e' a soma
+// normalizada das normais (nao unitarias, logo ponderadas pela area) dos
+// triangulos que o usam.
+//
+// Os triangulos sao divididos entre threads, cada uma somando num buffer
+// proprio (sem atomicos); os buffers sao somados e normalizados no fim,
+// tambem em paralelo. Com SSE, 4 triangulos e 4 vertices por vez.
+//
+// "posicoes": 3 floats por vertice. "triangulos": 3 indices de vertice por
+// triangulo. "normais" recebe 3 floats por vertice; vertices fora de todos
+// os triangulos ficam com normal zero. numThreads <= 0: uma por nucleo.
+void CalculaNormaisVertices(const float* posicoes, size_t numVertices,
+                            const std::vector<int>& triangulos,
+                            std::vector<float>* normais, int numThreads = 0);
+
+#endif // _VERTEX_NORMALS_H
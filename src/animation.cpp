@@ -0,0 +1,142 @@
+#include <animation.h>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define ANIMACAO_SSE
+#endif
+
+// Os vetores tem tamanho multiplo de 4; o excesso fica parado em t = 1.
+#define LARGURA_SIMD 4
+
+void IniciaAnimacao(TAnimacao* a, float duracao)
+{
+    a->nodos.clear();
+    a->duracao = duracao;
+    a->parado = true;
+    a->geracao = GeracaoArvore();
+}
+
+void AnimaArvore(TAnimacao* a, pNodoA* raiz)
+{
+    static TPercurso percurso;
+    a->geracao = GeracaoArvore();
+    a->nodos.clear();
+    IniciaPercurso(&percurso, raiz, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso))
+        a->nodos.push_back(n);
+
+    size_t n = a->nodos.size();
+    size_t total = (n + LARGURA_SIMD - 1) / LARGURA_SIMD * LARGURA_SIMD;
+    a->x0.assign(total, 0.0f);
+    a->y0.assign(total, 0.0f);
+    a->dx.assign(total, 0.0f);
+    a->dy.assign(total, 0.0f);
+    a->t.assign(total, 1.0f);
+    a->x.assign(total, 0.0f);
+    a->y.assign(total, 0.0f);
+
+    a->parado = true;
+    for (size_t i = 0; i < n; i++) {
+        pNodoA* nodo = a->nodos[i];
+        a->x0[i] = (float) nodo->currX;
+        a->y0[i] = (float) nodo->currY;
+        a->dx[i] = (float) (nodo->x - nodo->currX);
+        a->dy[i] = (float) (nodo->y - nodo->currY);
+        a->x[i] = a->x0[i];
+        a->y[i] = a->y0[i];
+        if (a->dx[i] != 0.0f || a->dy[i] != 0.0f) {
+            a->t[i] = 0.0f;
+            a->parado = false;
+        }
+    }
+}
+
+// Leva o progresso de todos os nodos a t + passo ou, se "absoluto", a passo.
+static bool calcula(TAnimacao* a, float passo, bool absoluto)
+{
+    // a arvore mudou depois de AnimaArvore(): os nodos podem nao existir mais
+    if (a->geracao != GeracaoArvore())
+        return a->parado;
+
+    size_t total = a->t.size();
+    float* t = a->t.data();
+    const float* x0 = a->x0.data();
+    const float* y0 = a->y0.data();
+    const float* dx = a->dx.data();
+    const float* dy = a->dy.data();
+    float* x = a->x.data();
+    float* y = a->y.data();
+    bool parado = true;
+
+#ifdef ANIMACAO_SSE
+    const __m128 um = _mm_set1_ps(1.0f);
+    const __m128 tres = _mm_set1_ps(3.0f);
+    const __m128 dois = _mm_set1_ps(2.0f);
+    const __m128 vpasso = _mm_set1_ps(passo);
+    __m128 menor = um;
+    for (size_t i = 0; i < total; i += LARGURA_SIMD) {
+        __m128 vt = absoluto ? vpasso : _mm_add_ps(_mm_loadu_ps(t + i), vpasso);
+        vt = _mm_min_ps(vt, um);
+        _mm_storeu_ps(t + i, vt);
+        menor = _mm_min_ps(menor, vt);
+        // smoothstep: t^2 (3 - 2t)
+        __m128 e = _mm_mul_ps(_mm_mul_ps(vt, vt), _mm_sub_ps(tres, _mm_mul_ps(dois, vt)));
+        _mm_storeu_ps(x + i, _mm_add_ps(_mm_loadu_ps(x0 + i), _mm_mul_ps(_mm_loadu_ps(dx + i), e)));
+        _mm_storeu_ps(y + i, _mm_add_ps(_mm_loadu_ps(y0 + i), _mm_mul_ps(_mm_loadu_ps(dy + i), e)));
+    }
+    parado = _mm_movemask_ps(_mm_cmplt_ps(menor, um)) == 0;
+#else
+    for (size_t i = 0; i < total; i++) {
+        float vt = absoluto ? passo : t[i] + passo;
+        if (vt > 1.0f)
+            vt = 1.0f;
+        t[i] = vt;
+        if (vt < 1.0f)
+            parado = false;
+        float e = vt * vt * (3.0f - 2.0f * vt);
+        x[i] = x0[i] + dx[i] * e;
+        y[i] = y0[i] + dy[i] * e;
+    }
+#endif
+
+    size_t n = a->nodos.size();
+    for (size_t i = 0; i < n; i++) {
+        pNodoA* nodo = a->nodos[i];
+        // na chegada usamos o destino exato, sem o erro do float
+        if (t[i] >= 1.0f || (dx[i] == 0.0f && dy[i] == 0.0f)) {
+            nodo->currX = nodo->x;
+            nodo->currY = nodo->y;
+        }
+        else {
+            nodo->currX = x[i];
+            nodo->currY = y[i];
+        }
+    }
+
+    a->parado = parado;
+    return parado;
+}
+
+bool AvancaAnimacao(TAnimacao* a, float dt)
+{
+    if (a->parado)
+        return true;
+    return calcula(a, a->duracao > 0.0f ? dt / a->duracao : 1.0f, false);
+}
+
+bool PosicionaAnimacao(TAnimacao* a, float decorrido)
+{
+    if (a->parado)
+        return true;
+    return calcula(a, a->duracao > 0.0f ? decorrido / a->duracao : 1.0f, true);
+}
+
+void PosicaoAnimacao(const TAnimacao* a, size_t i, float decorrido, float* x, float* y)
+{
+    float t = a->duracao > 0.0f ? decorrido / a->duracao : 1.0f;
+    if (t > 1.0f)
+        t = 1.0f;
+    float e = t * t * (3.0f - 2.0f * t);
+    *x = a->x0[i] + a->dx[i] * e;
+    *y = a->y0[i] + a->dy[i] * e;
+}
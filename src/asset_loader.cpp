@@ -0,0 +1,147 @@
+#include <asset_loader.h>
+
+#include <chrono>
+#include <cstdio>
+
+static double agora(const TCarregador* c)
+{
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count() - c->relogio0;
+}
+
+static void trabalhador(TCarregador* c)
+{
+    for (;;)
+    {
+        TCarga* carga;
+        {
+            std::unique_lock<std::mutex> trava(c->trava);
+            c->temTrabalho.wait(trava, [c]() { return c->encerrando || !c->pendentes.empty(); });
+            if (c->pendentes.empty())
+                return;
+            carga = c->pendentes.front();
+            c->pendentes.pop_front();
+            carga->inicio = agora(c);
+        }
+
+        carga->trabalho();
+
+        std::lock_guard<std::mutex> trava(c->trava);
+        carga->fimTrabalho = agora(c);
+        c->prontas.push_back(carga);
+    }
+}
+
+void IniciaCarregador(TCarregador* c, int numThreads)
+{
+    c->relogio0 = 0.0;
+    c->relogio0 = agora(c);
+    c->encerrando = false;
+    c->enviadas = 0;
+    c->aoTerminar = NULL;
+
+    if (numThreads <= 0)
+        numThreads = (int) std::thread::hardware_concurrency();
+    if (numThreads <= 0)
+        numThreads = 2;
+    for (int i = 0; i < numThreads; i++)
+        c->threads.push_back(std::thread(trabalhador, c));
+}
+
+void AgendaCarga(TCarregador* c, const char* nome,
+                 std::function<void()> trabalho, std::function<void()> envio)
+{
+    TCarga* carga = new TCarga();
+    carga->nome = nome;
+    carga->trabalho = trabalho;
+    carga->envio = envio;
+    carga->inicio = carga->fimTrabalho = carga->inicioEnvio = carga->fimEnvio = 0.0;
+    {
+        std::lock_guard<std::mutex> trava(c->trava);
+        carga->agendada = agora(c);
+        c->cargas.push_back(carga);
+        c->pendentes.push_back(carga);
+    }
+    c->temTrabalho.notify_one();
+}
+
+void DefineCallbackCargasProntas(TCarregador* c, CargasProntasCallback callback)
+{
+    c->aoTerminar = callback;
+}
+
+int TrataCargasProntas(TCarregador* c)
+{
+    std::deque<TCarga*> prontas;
+    {
+        std::lock_guard<std::mutex> trava(c->trava);
+        prontas.swap(c->prontas);
+    }
+
+    for (size_t i = 0; i < prontas.size(); i++)
+    {
+        prontas[i]->inicioEnvio = agora(c);
+        if (prontas[i]->envio)
+            prontas[i]->envio();
+        prontas[i]->fimEnvio = agora(c);
+    }
+
+    size_t total;
+    {
+        std::lock_guard<std::mutex> trava(c->trava);
+        c->enviadas += prontas.size();
+        total = c->cargas.size();
+    }
+    if (!prontas.empty() && c->enviadas == total && c->aoTerminar)
+    {
+        CargasProntasCallback callback = c->aoTerminar;
+        c->aoTerminar = NULL;
+        callback();
+    }
+    return (int) prontas.size();
+}
+
+bool CargasTerminadas(TCarregador* c)
+{
+    std::lock_guard<std::mutex> trava(c->trava);
+    return c->enviadas == c->cargas.size();
+}
+
+void ImprimeRelatorioCargas(TCarregador* c)
+{
+    std::lock_guard<std::mutex> trava(c->trava);
+    printf("Carga (%d threads)             fila  trabalho    espera     envio     pronto (ms)\n",
+           (int) c->threads.size());
+    double fim = 0.0;
+    for (size_t i = 0; i < c->cargas.size(); i++)
+    {
+        const TCarga* k = c->cargas[i];
+        if (k->fimEnvio == 0.0)
+            continue;
+        printf("  %-28s %8.1f %9.1f %9.1f %9.1f %10.1f\n", k->nome.c_str(),
+               1000.0 * (k->inicio - k->agendada), 1000.0 * (k->fimTrabalho - k->inicio),
+               1000.0 * (k->inicioEnvio - k->fimTrabalho), 1000.0 * (k->fimEnvio - k->inicioEnvio),
+               1000.0 * k->fimEnvio);
+        if (k->fimEnvio > fim)
+            fim = k->fimEnvio;
+    }
+    printf("  total: %.1f ms\n", 1000.0 * fim);
+}
+
+void EncerraCarregador(TCarregador* c)
+{
+    {
+        std::lock_guard<std::mutex> trava(c->trava);
+        c->encerrando = true;
+    }
+    c->temTrabalho.notify_all();
+    for (size_t i = 0; i < c->threads.size(); i++)
+        c->threads[i].join();
+    c->threads.clear();
+
+    for (size_t i = 0; i < c->cargas.size(); i++)
+        delete c->cargas[i];
+    c->cargas.clear();
+    c->pendentes.clear();
+    c->prontas.clear();
+}
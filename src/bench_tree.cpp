@@ -0,0 +1,129 @@
+// Medicoes de desempenho das estruturas de src/tree.cpp e derivadas.
+// Compile e rode com "make bench".
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+#include "tree.h"
+#include "node_pool.h"
+#include "compact_tree.h"
+#include "eytzinger.h"
+
+using namespace std;
+
+static const int NUM_CHAVES    = 1 << 20;
+static const int NUM_CONSULTAS = 1 << 22;
+
+// xorshift32: rand() tem so 15 bits em algumas plataformas
+static unsigned aleatorio()
+{
+    static unsigned estado = 2463534242u;
+    estado ^= estado << 13;
+    estado ^= estado >> 17;
+    estado ^= estado << 5;
+    return estado;
+}
+
+static double agora()
+{
+    return chrono::duration<double>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Imprime o tempo medio por consulta; "achados" impede que o compilador
+// descarte as buscas.
+static void relata(const char* nome, double inicio, long achados)
+{
+    double ns = (agora() - inicio) * 1e9 / NUM_CONSULTAS;
+    printf("  %-28s %7.1f ns/consulta  (%ld achados)\n", nome, ns, achados);
+}
+
+static void consultas(const char* titulo, pNodoA* arvore, const vector<int>& chaves)
+{
+    printf("%s: %d nodos, altura %d\n", titulo, tamanhoArvore(arvore), alturaArvore(arvore));
+
+    double t = agora();
+    long achados = 0;
+    for (int i = 0; i < NUM_CONSULTAS; ++i)
+        achados += consultaABP(arvore, chaves[i]) != NULL;
+    relata("consultaABP", t, achados);
+
+    vector<pNodoA*> resultados(NUM_CONSULTAS);
+    t = agora();
+    consultaABPBatch(arvore, chaves.data(), NUM_CONSULTAS, resultados.data());
+    achados = 0;
+    for (int i = 0; i < NUM_CONSULTAS; ++i)
+        achados += resultados[i] != NULL;
+    relata("consultaABPBatch", t, achados);
+
+    TArvoreCompacta c;
+    CompactaArvore(arvore, &c);
+    t = agora();
+    achados = 0;
+    for (int i = 0; i < NUM_CONSULTAS; ++i)
+        achados += consultaCompacta(&c, chaves[i]) != NODO_NULO;
+    relata("consultaCompacta", t, achados);
+
+    TArvoreEytzinger e;
+    CongelaArvore(arvore, &e);
+    t = agora();
+    achados = 0;
+    for (int i = 0; i < NUM_CONSULTAS; ++i)
+        achados += consultaEytzinger(&e, chaves[i]) != NULL;
+    relata("consultaEytzinger", t, achados);
+}
+
+int main()
+{
+    // chaves em [0, 2N): cerca de metade das consultas acha a chave
+    vector<int> inseridas(NUM_CHAVES);
+    for (int i = 0; i < NUM_CHAVES; ++i)
+        inseridas[i] = aleatorio() % (2 * NUM_CHAVES);
+    vector<int> buscadas(NUM_CONSULTAS);
+    for (int i = 0; i < NUM_CONSULTAS; ++i)
+        buscadas[i] = aleatorio() % (2 * NUM_CHAVES);
+
+    int modos[2] = {ARVORE_ABP, ARVORE_AVL};
+    const char* nomes[2] = {"ABP, insercao aleatoria", "AVL, insercao aleatoria"};
+    for (int m = 0; m < 2; ++m)
+    {
+        DefineModoArvore(modos[m]);
+        pNodoA* arvore = NULL;
+        for (int i = 0; i < NUM_CHAVES; ++i)
+            arvore = InsereArvore(arvore, inseridas[i]);
+
+        consultas(nomes[m], arvore, buscadas);
+
+        EsvaziaPool(PoolArvore());
+    }
+
+    // Carga de NUM_CHAVES chaves: insercao uma a uma contra ConstroiArvore
+    vector<int> ordenadas(NUM_CHAVES);
+    for (int i = 0; i < NUM_CHAVES; ++i)
+        ordenadas[i] = i;
+
+    printf("Carga de %d chaves (AVL)\n", NUM_CHAVES);
+    DefineModoArvore(ARVORE_AVL);
+    double t = agora();
+    pNodoA* arvore = NULL;
+    for (int i = 0; i < NUM_CHAVES; ++i)
+        arvore = InsereArvore(arvore, ordenadas[i]);
+    printf("  %-28s %7.1f ms\n", "InsereArvore, ordenadas", (agora() - t) * 1e3);
+    EsvaziaPool(PoolArvore());
+
+    t = agora();
+    ConstroiArvore(ordenadas.data(), NUM_CHAVES, true, false);
+    printf("  %-28s %7.1f ms\n", "ConstroiArvore, ordenadas", (agora() - t) * 1e3);
+    EsvaziaPool(PoolArvore());
+
+    t = agora();
+    ConstroiArvore(inseridas.data(), NUM_CHAVES, false, false);
+    printf("  %-28s %7.1f ms\n", "ConstroiArvore, aleatorias", (agora() - t) * 1e3);
+    EsvaziaPool(PoolArvore());
+
+    t = agora();
+    ConstroiArvore(inseridas.data(), NUM_CHAVES, false, true);
+    printf("  %-28s %7.1f ms\n", "  com ordenacao paralela", (agora() - t) * 1e3);
+    EsvaziaPool(PoolArvore());
+    return 0;
+}
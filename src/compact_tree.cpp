@@ -0,0 +1,138 @@
+#include <compact_tree.h>
+
+void IniciaArvoreCompacta(TArvoreCompacta* c)
+{
+    c->nodos.clear();
+    c->x.clear();
+    c->y.clear();
+    c->raiz = NODO_NULO;
+    c->livres = NODO_NULO;
+}
+
+static uint32_t novoNodoC(TArvoreCompacta* c, int ch, float x, float y)
+{
+    uint32_t i;
+    if (c->livres != NODO_NULO) {
+        i = c->livres;
+        c->livres = c->nodos[i].esq;
+    }
+    else {
+        i = (uint32_t) c->nodos.size();
+        c->nodos.push_back(TNodoC());
+        c->x.push_back(0.0f);
+        c->y.push_back(0.0f);
+    }
+    c->nodos[i].info = ch;
+    c->nodos[i].esq = NODO_NULO;
+    c->nodos[i].dir = NODO_NULO;
+    c->x[i] = x;
+    c->y[i] = y;
+    return i;
+}
+
+void CompactaArvore(pNodoA* a, TArvoreCompacta* c)
+{
+    IniciaArvoreCompacta(c);
+    c->nodos.reserve(tamanhoArvore(a));
+    c->x.reserve(tamanhoArvore(a));
+    c->y.reserve(tamanhoArvore(a));
+
+    // para cada nodo a copiar, guardamos o link que deve apontar para a copia
+    std::vector<pNodoA*> pilha;
+    std::vector<uint32_t*> links;
+    if (a) {
+        pilha.push_back(a);
+        links.push_back(&c->raiz);
+    }
+
+    while (!pilha.empty()) {
+        pNodoA* n = pilha.back();
+        uint32_t* link = links.back();
+        pilha.pop_back();
+        links.pop_back();
+
+        // "link" aponta para dentro de c->nodos, que nao realoca: reservamos antes
+        uint32_t i = novoNodoC(c, n->info, (float) n->x, (float) n->y);
+        *link = i;
+
+        if (n->dir) {
+            pilha.push_back(n->dir);
+            links.push_back(&c->nodos[i].dir);
+        }
+        if (n->esq) {
+            pilha.push_back(n->esq);
+            links.push_back(&c->nodos[i].esq);
+        }
+    }
+}
+
+uint32_t InsereCompacta(TArvoreCompacta* c, int ch)
+{
+    uint32_t pai = NODO_NULO;
+    uint32_t i = c->raiz;
+    while (i != NODO_NULO) {
+        if (ch == c->nodos[i].info)
+            return i;
+        pai = i;
+        i = ch < c->nodos[i].info ? c->nodos[i].esq : c->nodos[i].dir;
+    }
+
+    // novoNodoC pode realocar c->nodos; so ligamos o pai depois dele
+    i = novoNodoC(c, ch, 0.0f, 0.0f);
+    if (pai == NODO_NULO)
+        c->raiz = i;
+    else if (ch < c->nodos[pai].info)
+        c->nodos[pai].esq = i;
+    else
+        c->nodos[pai].dir = i;
+    return i;
+}
+
+void RemoveCompacta(TArvoreCompacta* c, int ch)
+{
+    uint32_t* link = &c->raiz;
+    while (*link != NODO_NULO && c->nodos[*link].info != ch)
+        link = ch < c->nodos[*link].info ? &c->nodos[*link].esq : &c->nodos[*link].dir;
+    if (*link == NODO_NULO)
+        return;
+
+    uint32_t i = *link;
+    TNodoC& n = c->nodos[i];
+
+    if (n.esq != NODO_NULO && n.dir != NODO_NULO) {
+        // dois filhos: o sucessor em ordem toma o lugar do nodo
+        uint32_t* linkSucessor = &n.dir;
+        while (c->nodos[*linkSucessor].esq != NODO_NULO)
+            linkSucessor = &c->nodos[*linkSucessor].esq;
+
+        uint32_t s = *linkSucessor;
+        n.info = c->nodos[s].info;
+        c->x[i] = c->x[s];
+        c->y[i] = c->y[s];
+        *linkSucessor = c->nodos[s].dir;
+        i = s;
+    }
+    else
+        *link = n.esq != NODO_NULO ? n.esq : n.dir;
+
+    c->nodos[i].esq = c->livres;
+    c->livres = i;
+}
+
+uint32_t consultaCompacta(const TArvoreCompacta* c, int chave)
+{
+    uint32_t i = c->raiz;
+    const TNodoC* nodos = c->nodos.data();
+    while (i != NODO_NULO) {
+        if (nodos[i].info == chave)
+            return i;
+        i = nodos[i].info > chave ? nodos[i].esq : nodos[i].dir;
+    }
+    return NODO_NULO;
+}
+
+size_t MemoriaCompacta(const TArvoreCompacta* c)
+{
+    return c->nodos.capacity() * sizeof(TNodoC)
+         + (c->x.capacity() + c->y.capacity()) * sizeof(float);
+}
@@ -0,0 +1,52 @@
+#include <eytzinger.h>
+
+// Preenche a posicao k (e sua subarvore) com os proximos valores em ordem.
+static void preenche(TArvoreEytzinger* e, const std::vector<pNodoA*>& emOrdem, int& i, int k)
+{
+    if (k > e->n)
+        return;
+    preenche(e, emOrdem, i, 2*k);
+    e->chaves[k] = emOrdem[i]->info;
+    e->nodos[k] = emOrdem[i];
+    i++;
+    preenche(e, emOrdem, i, 2*k + 1);
+}
+
+void CongelaArvore(pNodoA* a, TArvoreEytzinger* e)
+{
+    e->n = tamanhoArvore(a);
+    e->chaves.assign(e->n + 1, 0);
+    e->nodos.assign(e->n + 1, (pNodoA*) NULL);
+
+    std::vector<pNodoA*> emOrdem;
+    emOrdem.reserve(e->n);
+    TPercurso p;
+    IniciaPercurso(&p, a, PERCURSO_EM);
+    for (pNodoA* n = ProximoNodo(&p); n != NULL; n = ProximoNodo(&p))
+        emOrdem.push_back(n);
+
+    int i = 0;
+    preenche(e, emOrdem, i, 1);
+}
+
+pNodoA* consultaEytzinger(const TArvoreEytzinger* e, int chave)
+{
+    const int* b = e->chaves.data();
+    size_t n = e->n;
+    size_t k = 1;
+
+    // Sem desvios dependentes da chave. Os 16 descendentes de k quatro
+    // niveis abaixo ficam em 16k..16k+15, que cabem numa linha de cache de
+    // 64 bytes: pedimos ela enquanto descemos os niveis intermediarios.
+    while (k <= n) {
+        __builtin_prefetch(b + 16*k);
+        k = 2*k + (b[k] < chave);
+    }
+    // Desfaz as descidas a direita apos a ultima a esquerda: k passa a ser
+    // o menor elemento >= chave (ou 0, se nao existe).
+    k >>= __builtin_ffsll(~(long long) k);
+
+    if (k != 0 && b[k] == chave)
+        return e->nodos[k];
+    return NULL;
+}
@@ -0,0 +1,429 @@
+#include <fast_obj_loader.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include <mapped_file.h>
+
+using tinyobj::index_t;
+
+// Pedacos menores que isso nao compensam uma thread.
+#define PEDACO_MINIMO (256 * 1024)
+
+static inline bool ehEspaco(char c) { return c == ' ' || c == '\t'; }
+static inline bool ehFimLinha(char c) { return c == '\r' || c == '\n' || c == '\0'; }
+static inline bool ehDigito(char c) { return c >= '0' && c <= '9'; }
+
+double LeNumeroObj(const char** s, const char* fim)
+{
+    static const double potencias[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char* p = *s;
+    const char* inicio = p;
+    bool negativo = false;
+    if (p < fim && (*p == '+' || *p == '-'))
+    {
+        negativo = *p == '-';
+        p++;
+    }
+
+    // Ate' 19 digitos significativos cabem sem erro num inteiro de 64 bits;
+    // os seguintes so' mudam o expoente.
+    unsigned long long mantissa = 0;
+    int digitos = 0, expoente10 = 0, lidos = 0;
+    for (; p < fim && ehDigito(*p); p++, lidos++)
+    {
+        if (digitos < 19) { mantissa = mantissa*10 + (*p - '0'); if (mantissa) digitos++; }
+        else expoente10++;
+    }
+    if (lidos == 0)
+    {
+        *s = inicio;
+        return 0.0;
+    }
+    if (p < fim && *p == '.')
+    {
+        for (p++; p < fim && ehDigito(*p); p++)
+        {
+            if (digitos < 19) { mantissa = mantissa*10 + (*p - '0'); if (mantissa) digitos++; expoente10--; }
+        }
+    }
+    if (p < fim && (*p == 'e' || *p == 'E'))
+    {
+        const char* e = p + 1;
+        bool expNegativo = false;
+        if (e < fim && (*e == '+' || *e == '-'))
+        {
+            expNegativo = *e == '-';
+            e++;
+        }
+        if (e >= fim || !ehDigito(*e))
+        {
+            // "1e" ou "1e+": tinyobj rejeita o numero inteiro
+            *s = inicio;
+            return 0.0;
+        }
+        int x = 0;
+        for (; e < fim && ehDigito(*e); e++)
+            if (x < 10000) x = x*10 + (*e - '0');
+        expoente10 += expNegativo ? -x : x;
+        p = e;
+    }
+    *s = p;
+
+    double valor;
+    if (mantissa < (1ull << 53) && expoente10 >= -22 && expoente10 <= 22)
+    {
+        // Mantissa e 10^|e| exatos em double: uma so' operacao, bem arredondada.
+        valor = (double) mantissa;
+        valor = expoente10 < 0 ? valor / potencias[-expoente10] : valor * potencias[expoente10];
+    }
+    else
+    {
+        char buffer[64];
+        size_t n = (size_t)(p - inicio);
+        if (n >= sizeof(buffer))
+            n = sizeof(buffer) - 1;
+        memcpy(buffer, inicio, n);
+        buffer[n] = '\0';
+        return strtod(buffer, NULL);
+    }
+    return negativo ? -valor : valor;
+}
+
+// Como parseFloat() de tinyobj: o campo vai ate' o proximo espaco; se nao
+// comecar com um numero valido, vale "padrao".
+static inline float leFloat(const char** s, const char* fim, double padrao = 0.0)
+{
+    const char* p = *s;
+    while (p < fim && ehEspaco(*p))
+        p++;
+    const char* fimCampo = p;
+    while (fimCampo < fim && !ehEspaco(*fimCampo) && *fimCampo != '\r' && *fimCampo != '\n')
+        fimCampo++;
+    const char* q = p;
+    double v = LeNumeroObj(&q, fimCampo);
+    *s = fimCampo;
+    return (float)(q == p ? padrao : v);
+}
+
+// Como atoi(): sinal opcional e digitos.
+static inline int leInteiro(const char** s, const char* fim)
+{
+    const char* p = *s;
+    bool negativo = false;
+    if (p < fim && (*p == '+' || *p == '-'))
+    {
+        negativo = *p == '-';
+        p++;
+    }
+    int v = 0;
+    for (; p < fim && ehDigito(*p); p++)
+        v = v*10 + (*p - '0');
+    *s = p;
+    return negativo ? -v : v;
+}
+
+// Como o strcspn(token, "/ \t\r") de tinyobj: pula o resto do campo.
+static inline const char* pulaCampo(const char* s, const char* fim)
+{
+    while (s < fim && *s != '/' && !ehEspaco(*s) && *s != '\r')
+        s++;
+    return s;
+}
+
+// Inicio de shape ("g" ou "o") dentro de um pedaco.
+struct TEventoShape
+{
+    size_t      faces;      // faces do pedaco antes do evento
+    size_t      triangulos; // triangulos do pedaco antes do evento
+    std::string nome;
+};
+
+struct TPedaco
+{
+    const char* inicio;
+    const char* fim;
+
+    std::vector<float>   v, vn, vt;
+    std::vector<index_t> indices;    // ja' triangulados
+    std::vector<size_t>  relativos;  // 3*posicao + componente de cada indice negativo
+    std::vector<TEventoShape> eventos;
+    size_t faces;
+    bool   naoSuportado;
+};
+
+// Indice de um vertice da face, como fixIndex() de tinyobj. Negativos sao
+// relativos ao que ja' foi lido; aqui so' se conhece o que o pedaco leu, e
+// o deslocamento dos pedacos anteriores e' somado na juncao.
+static inline int corrigeIndice(int i, int lidosNoPedaco, bool* relativo)
+{
+    *relativo = i < 0;
+    if (i > 0) return i - 1;
+    if (i == 0) return 0;
+    return lidosNoPedaco + i;
+}
+
+static void lePedaco(TPedaco* pd)
+{
+    const char* p = pd->inicio;
+    const char* fim = pd->fim;
+    std::vector<index_t> face;
+    std::vector<unsigned char> relativosFace; // bits: vertice, texcoord, normal
+
+    while (p < fim)
+    {
+        const char* linha = p;
+        const char* fimLinha = (const char*) memchr(p, '\n', fim - p);
+        if (!fimLinha)
+            fimLinha = fim;
+        p = fimLinha + (fimLinha < fim ? 1 : 0);
+
+        while (linha < fimLinha && ehEspaco(*linha))
+            linha++;
+        if (linha >= fimLinha || *linha == '#' || *linha == '\r')
+            continue;
+        char c0 = linha[0];
+        char c1 = linha + 1 < fimLinha ? linha[1] : '\0';
+        char c2 = linha + 2 < fimLinha ? linha[2] : '\0';
+
+        if (c0 == 'v' && ehEspaco(c1))
+        {
+            const char* s = linha + 2;
+            pd->v.push_back(leFloat(&s, fimLinha));
+            pd->v.push_back(leFloat(&s, fimLinha));
+            pd->v.push_back(leFloat(&s, fimLinha));
+        }
+        else if (c0 == 'v' && c1 == 'n' && ehEspaco(c2))
+        {
+            const char* s = linha + 3;
+            pd->vn.push_back(leFloat(&s, fimLinha));
+            pd->vn.push_back(leFloat(&s, fimLinha));
+            pd->vn.push_back(leFloat(&s, fimLinha));
+        }
+        else if (c0 == 'v' && c1 == 't' && ehEspaco(c2))
+        {
+            const char* s = linha + 3;
+            pd->vt.push_back(leFloat(&s, fimLinha));
+            pd->vt.push_back(leFloat(&s, fimLinha));
+        }
+        else if (c0 == 'f' && ehEspaco(c1))
+        {
+            const char* s = linha + 2;
+            int nv = (int)(pd->v.size() / 3), nvn = (int)(pd->vn.size() / 3), nvt = (int)(pd->vt.size() / 2);
+            face.clear();
+            relativosFace.clear();
+            bool temRelativo = false;
+            while (s < fimLinha && ehEspaco(*s))
+                s++;
+            while (s < fimLinha && !ehFimLinha(*s))
+            {
+                // Mesma sequencia de parseTriple(): i, i/j, i//k, i/j/k.
+                index_t idx;
+                idx.vertex_index = idx.texcoord_index = idx.normal_index = -1;
+                bool r;
+                unsigned char relativos = 0;
+                idx.vertex_index = corrigeIndice(leInteiro(&s, fimLinha), nv, &r);
+                relativos |= r ? 1 : 0;
+                s = pulaCampo(s, fimLinha);
+                if (s < fimLinha && *s == '/')
+                {
+                    s++;
+                    if (s < fimLinha && *s == '/')
+                    {
+                        s++;
+                        idx.normal_index = corrigeIndice(leInteiro(&s, fimLinha), nvn, &r);
+                        relativos |= r ? 4 : 0;
+                        s = pulaCampo(s, fimLinha);
+                    }
+                    else
+                    {
+                        idx.texcoord_index = corrigeIndice(leInteiro(&s, fimLinha), nvt, &r);
+                        relativos |= r ? 2 : 0;
+                        s = pulaCampo(s, fimLinha);
+                        if (s < fimLinha && *s == '/')
+                        {
+                            s++;
+                            idx.normal_index = corrigeIndice(leInteiro(&s, fimLinha), nvn, &r);
+                            relativos |= r ? 4 : 0;
+                            s = pulaCampo(s, fimLinha);
+                        }
+                    }
+                }
+                face.push_back(idx);
+                relativosFace.push_back(relativos);
+                temRelativo = temRelativo || relativos;
+                while (s < fimLinha && (ehEspaco(*s) || *s == '\r'))
+                    s++;
+            }
+
+            // Leque a partir do primeiro vertice, como exportFaceGroupToShape().
+            for (size_t k = 2; k < face.size(); k++)
+            {
+                size_t vertices[3] = { 0, k - 1, k };
+                for (int j = 0; j < 3; j++)
+                {
+                    // Raro: guarda onde estao os indices negativos para a juncao.
+                    if (temRelativo)
+                        for (int comp = 0; comp < 3; comp++)
+                            if (relativosFace[vertices[j]] & (1 << comp))
+                                pd->relativos.push_back(3*pd->indices.size() + comp);
+                    pd->indices.push_back(face[vertices[j]]);
+                }
+            }
+            pd->faces++;
+        }
+        else if ((c0 == 'g' || c0 == 'o') && ehEspaco(c1))
+        {
+            // "g nome ..." e "o nome": vale a primeira palavra.
+            const char* s = linha + 2;
+            while (s < fimLinha && ehEspaco(*s))
+                s++;
+            const char* e = s;
+            while (e < fimLinha && !ehEspaco(*e) && *e != '\r')
+                e++;
+            TEventoShape ev;
+            ev.faces = pd->faces;
+            ev.triangulos = pd->indices.size() / 3;
+            ev.nome.assign(s, e);
+            pd->eventos.push_back(ev);
+        }
+        else if ((c0 == 't' && ehEspaco(c1)) ||
+                 (fimLinha - linha >= 7 && memcmp(linha, "mtllib", 6) == 0 && ehEspaco(linha[6])))
+        {
+            pd->naoSuportado = true;
+            return;
+        }
+        // "s", "usemtl" (sem mtllib, o material e' sempre -1) e o resto: ignorados
+    }
+}
+
+bool LeObjRapido(const char* caminho, tinyobj::attrib_t* attrib,
+                 std::vector<tinyobj::shape_t>* shapes, int numThreads)
+{
+    TArquivoMapeado arquivo;
+    if (!MapeiaArquivo(caminho, &arquivo))
+        return false;
+
+    if (numThreads <= 0)
+        numThreads = (int) std::thread::hardware_concurrency();
+    size_t numPedacos = arquivo.tamanho / PEDACO_MINIMO + 1;
+    if (numThreads > 0 && numPedacos > (size_t) numThreads)
+        numPedacos = numThreads;
+
+    // Cortes logo depois de um fim de linha.
+    std::vector<TPedaco> pedacos(numPedacos);
+    const char* dados = arquivo.dados;
+    const char* fimArquivo = dados + arquivo.tamanho;
+    const char* inicio = dados;
+    for (size_t i = 0; i < numPedacos; i++)
+    {
+        const char* fim = i + 1 == numPedacos ? fimArquivo : dados + arquivo.tamanho * (i + 1) / numPedacos;
+        if (fim < inicio)
+            fim = inicio;
+        const char* nl = fim < fimArquivo ? (const char*) memchr(fim, '\n', fimArquivo - fim) : NULL;
+        fim = nl ? nl + 1 : fimArquivo;
+        pedacos[i].inicio = inicio;
+        pedacos[i].fim = fim;
+        pedacos[i].faces = 0;
+        pedacos[i].naoSuportado = false;
+        inicio = fim;
+    }
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < numPedacos; i++)
+        threads.push_back(std::thread(lePedaco, &pedacos[i]));
+    lePedaco(&pedacos[0]);
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    DesmapeiaArquivo(&arquivo);
+
+    for (size_t i = 0; i < numPedacos; i++)
+        if (pedacos[i].naoSuportado)
+            return false;
+
+    // Juncao: atributos em sequencia, indices negativos deslocados pelo que
+    // os pedacos anteriores leram.
+    size_t tv = 0, tvn = 0, tvt = 0;
+    for (size_t i = 0; i < numPedacos; i++)
+    {
+        tv += pedacos[i].v.size();
+        tvn += pedacos[i].vn.size();
+        tvt += pedacos[i].vt.size();
+    }
+    attrib->vertices.clear();
+    attrib->normals.clear();
+    attrib->texcoords.clear();
+    attrib->vertices.reserve(tv);
+    attrib->normals.reserve(tvn);
+    attrib->texcoords.reserve(tvt);
+    shapes->clear();
+
+    // Shape aberta: nome, pedaco e triangulo onde comecou, e se ja' tem
+    // alguma face (tinyobj descarta grupos vazios).
+    std::string nome;
+    size_t pedacoInicio = 0, trianguloInicio = 0;
+    bool temFaces = false;
+
+    for (size_t i = 0; i < numPedacos; i++)
+    {
+        TPedaco& pd = pedacos[i];
+        int desloc[3] = { (int)(attrib->vertices.size() / 3), (int)(attrib->texcoords.size() / 2),
+                          (int)(attrib->normals.size() / 3) };
+        for (size_t k = 0; k < pd.relativos.size(); k++)
+        {
+            index_t& idx = pd.indices[pd.relativos[k] / 3];
+            switch (pd.relativos[k] % 3)
+            {
+            case 0: idx.vertex_index += desloc[0]; break;
+            case 1: idx.texcoord_index += desloc[1]; break;
+            case 2: idx.normal_index += desloc[2]; break;
+            }
+        }
+        attrib->vertices.insert(attrib->vertices.end(), pd.v.begin(), pd.v.end());
+        attrib->normals.insert(attrib->normals.end(), pd.vn.begin(), pd.vn.end());
+        attrib->texcoords.insert(attrib->texcoords.end(), pd.vt.begin(), pd.vt.end());
+
+        size_t facesAntes = 0;
+        for (size_t e = 0; e <= pd.eventos.size(); e++)
+        {
+            bool fimPedaco = e == pd.eventos.size();
+            size_t faces = fimPedaco ? pd.faces : pd.eventos[e].faces;
+            temFaces = temFaces || faces > facesAntes;
+            facesAntes = faces;
+            if (fimPedaco && i + 1 < numPedacos)
+                break;
+
+            if (temFaces)
+            {
+                size_t trianguloFim = fimPedaco ? pd.indices.size() / 3 : pd.eventos[e].triangulos;
+                shapes->push_back(tinyobj::shape_t());
+                tinyobj::shape_t& shape = shapes->back();
+                shape.name = nome;
+                for (size_t j = pedacoInicio; j <= i; j++)
+                {
+                    const std::vector<index_t>& ind = pedacos[j].indices;
+                    size_t a = j == pedacoInicio ? 3*trianguloInicio : 0;
+                    size_t b = j == i ? 3*trianguloFim : ind.size();
+                    shape.mesh.indices.insert(shape.mesh.indices.end(), ind.begin() + a, ind.begin() + b);
+                }
+                shape.mesh.num_face_vertices.assign(shape.mesh.indices.size() / 3, 3);
+                shape.mesh.material_ids.assign(shape.mesh.indices.size() / 3, -1);
+            }
+            if (!fimPedaco)
+            {
+                nome = pd.eventos[e].nome;
+                pedacoInicio = i;
+                trianguloInicio = pd.eventos[e].triangulos;
+                temFaces = false;
+            }
+        }
+    }
+
+    return true;
+}
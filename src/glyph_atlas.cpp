@@ -0,0 +1,154 @@
+#include <cmath>
+#include <glyph_atlas.h>
+
+using namespace std;
+
+// Margem dentro de cada glifo, meia largura do traco e alcance do campo, em pixels.
+#define ATLAS_MARGEM  6.0f
+#define ATLAS_TRACO   3.0f
+#define ATLAS_ALCANCE 5.0f
+
+#define PI 3.14159265358979f
+
+struct TSegmento
+{
+    float x0, y0, x1, y1;
+};
+
+// Tracos em coordenadas do glifo: x e y em [0, 1], y para cima.
+static void linha(vector<TSegmento>& s, const float* pontos, int n)
+{
+    for (int i = 0; i + 1 < n; i++) {
+        TSegmento seg = { pontos[2*i], pontos[2*i + 1], pontos[2*i + 2], pontos[2*i + 3] };
+        s.push_back(seg);
+    }
+}
+
+// Arco de elipse de a0 a a1 (graus, anti-horario a partir de +x).
+static void arco(vector<TSegmento>& s, float cx, float cy, float rx, float ry, float a0, float a1)
+{
+    const int passos = 24;
+    float ax = cx + rx * cos(a0 * PI / 180), ay = cy + ry * sin(a0 * PI / 180);
+    for (int i = 1; i <= passos; i++) {
+        float a = (a0 + (a1 - a0) * i / passos) * PI / 180;
+        float bx = cx + rx * cos(a), by = cy + ry * sin(a);
+        TSegmento seg = { ax, ay, bx, by };
+        s.push_back(seg);
+        ax = bx;
+        ay = by;
+    }
+}
+
+static void tracosGlifo(int g, vector<TSegmento>& s)
+{
+    s.clear();
+    switch (g) {
+        case 0:
+            arco(s, 0.5f, 0.5f, 0.38f, 0.45f, 0, 360);
+            break;
+        case 1: {
+            float p[] = { 0.25f, 0.75f, 0.55f, 0.95f, 0.55f, 0.05f };
+            float b[] = { 0.25f, 0.05f, 0.85f, 0.05f };
+            linha(s, p, 3);
+            linha(s, b, 2);
+            break;
+        }
+        case 2: {
+            arco(s, 0.5f, 0.68f, 0.36f, 0.27f, 160, -20);
+            float p[] = { 0.84f, 0.59f, 0.12f, 0.05f, 0.88f, 0.05f };
+            linha(s, p, 3);
+            break;
+        }
+        case 3:
+            arco(s, 0.48f, 0.73f, 0.32f, 0.22f, 150, -90);
+            arco(s, 0.48f, 0.29f, 0.36f, 0.24f, 90, -150);
+            break;
+        case 4: {
+            float p[] = { 0.68f, 0.05f, 0.68f, 0.95f, 0.1f, 0.3f, 0.9f, 0.3f };
+            linha(s, p, 4);
+            break;
+        }
+        case 5: {
+            float p[] = { 0.85f, 0.95f, 0.22f, 0.95f, 0.17f, 0.55f };
+            linha(s, p, 3);
+            arco(s, 0.48f, 0.33f, 0.36f, 0.28f, 130, -150);
+            break;
+        }
+        case 6: {
+            arco(s, 0.5f, 0.3f, 0.34f, 0.25f, 0, 360);
+            float p[] = { 0.75f, 0.95f, 0.2f, 0.33f };
+            linha(s, p, 2);
+            break;
+        }
+        case 7: {
+            float p[] = { 0.12f, 0.95f, 0.88f, 0.95f, 0.38f, 0.05f };
+            linha(s, p, 3);
+            break;
+        }
+        case 8:
+            arco(s, 0.5f, 0.74f, 0.27f, 0.21f, 0, 360);
+            arco(s, 0.5f, 0.29f, 0.34f, 0.24f, 0, 360);
+            break;
+        case 9: {
+            arco(s, 0.5f, 0.7f, 0.34f, 0.25f, 0, 360);
+            float p[] = { 0.8f, 0.67f, 0.25f, 0.05f };
+            linha(s, p, 2);
+            break;
+        }
+        case ATLAS_GLIFO_MENOS: {
+            float p[] = { 0.2f, 0.5f, 0.8f, 0.5f };
+            linha(s, p, 2);
+            break;
+        }
+    }
+}
+
+static float distanciaSegmento(float px, float py, const TSegmento& s)
+{
+    float dx = s.x1 - s.x0, dy = s.y1 - s.y0;
+    float l2 = dx * dx + dy * dy;
+    float t = l2 > 0 ? ((px - s.x0) * dx + (py - s.y0) * dy) / l2 : 0;
+    t = t < 0 ? 0 : (t > 1 ? 1 : t);
+    float ex = s.x0 + t * dx - px, ey = s.y0 + t * dy - py;
+    return sqrt(ex * ex + ey * ey);
+}
+
+void GeraAtlasGlifos(vector<unsigned char>& pixels)
+{
+    const int largura = ATLAS_GLIFOS * ATLAS_GLIFO_LARGURA;
+    const float w = ATLAS_GLIFO_LARGURA - 2 * ATLAS_MARGEM;
+    const float h = ATLAS_GLIFO_ALTURA - 2 * ATLAS_MARGEM;
+    vector<TSegmento> tracos;
+
+    pixels.assign(largura * ATLAS_GLIFO_ALTURA, 0);
+    for (int g = 0; g < ATLAS_GLIFOS; g++) {
+        tracosGlifo(g, tracos);
+        // tracos em pixels do glifo
+        for (size_t i = 0; i < tracos.size(); i++) {
+            tracos[i].x0 = ATLAS_MARGEM + tracos[i].x0 * w;
+            tracos[i].x1 = ATLAS_MARGEM + tracos[i].x1 * w;
+            tracos[i].y0 = ATLAS_MARGEM + tracos[i].y0 * h;
+            tracos[i].y1 = ATLAS_MARGEM + tracos[i].y1 * h;
+        }
+
+        for (int y = 0; y < ATLAS_GLIFO_ALTURA; y++) {
+            for (int x = 0; x < ATLAS_GLIFO_LARGURA; x++) {
+                float d = 1e9f;
+                for (size_t i = 0; i < tracos.size(); i++)
+                    d = fmin(d, distanciaSegmento(x + 0.5f, y + 0.5f, tracos[i]));
+                float v = 0.5f + (ATLAS_TRACO - d) / (2 * ATLAS_ALCANCE);
+                v = v < 0 ? 0 : (v > 1 ? 1 : v);
+                pixels[y * largura + g * ATLAS_GLIFO_LARGURA + x] = (unsigned char) (v * 255 + 0.5f);
+            }
+        }
+    }
+}
+
+int GlifoAtlas(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c == '-')
+        return ATLAS_GLIFO_MENOS;
+    return -1;
+}
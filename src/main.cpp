@@ -20,6 +20,7 @@
 #include <fstream>
 #include <sstream>
 #include<iostream>
+#include <memory>
 
 // Headers das bibliotecas OpenGL
 #include <glad/glad.h>   // Criação de contexto OpenGL 3.3
@@ -40,6 +41,19 @@
 #include "utils.h"
 #include "matrices.h"
 #include "tree.h"
+#include "node_pool.h"
+#include "persistent_tree.h"
+#include "tidy_layout.h"
+#include "animation.h"
+#include "glyph_atlas.h"
+#include "render_queue.h"
+#include "static_geometry.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "mesh_cache.h"
+#include "asset_loader.h"
+#include "fast_obj_loader.h"
+#include "vertex_normals.h"
 #include "curvas_bezier.h"
 #include "collisions.h"
 
@@ -57,12 +71,16 @@ struct ObjModel
 
     // Este construtor lê o modelo de um arquivo utilizando a biblioteca tinyobjloader.
     // Veja: https://github.com/syoyo/tinyobjloader
+    // Com triangulação, tenta antes o leitor paralelo (fast_obj_loader.h),
+    // que produz o mesmo resultado; arquivos com materiais ficam com tinyobj.
     ObjModel(const char* filename, const char* basepath = NULL, bool triangulate = true)
     {
         printf("Carregando modelo \"%s\"... ", filename);
 
         std::string err;
-        bool ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
+        bool ret = triangulate && LeObjRapido(filename, &attrib, &shapes);
+        if (!ret)
+            ret = tinyobj::LoadObj(&attrib, &shapes, &materials, &err, filename, basepath, triangulate);
 
         if (!err.empty())
             fprintf(stderr, "\n%s\n", err.c_str());
@@ -74,11 +92,18 @@ struct ObjModel
     }
 };
 
-void BuildTrianglesAndAddToVirtualScene(ObjModel*); // Constrói representação de um ObjModel como malha de triângulos para renderização
+void CookObjModel(ObjModel* model, std::vector<TObjetoCozido>& objects); // Constrói a malha de triângulos de cada shape de um ObjModel
+void AddCookedObjectsToVirtualScene(const std::vector<TObjetoCozido>& objects); // Registra na cena as malhas construídas acima
+void LoadObjAsync(TCarregador* loader, const char* filename); // Agenda a carga de um OBJ (ou da sua cache de malhas)
+void OnSceneLoaded(); // Chamada quando todos os recursos foram carregados
 void ComputeNormals(ObjModel* model); // Computa normais de um ObjModel, caso não existam.
-void DrawVirtualObject(const char* object_name); // Desenha um objeto armazenado em g_VirtualScene
+struct SceneObject;
+int  AddVirtualObject(const SceneObject& object, const std::string& key); // Registra um objeto na cena e retorna seu handle
+int  FindVirtualObject(const char* key); // Handle de um objeto registrado, ou -1
 void LoadShadersFromFiles(); // Carrega os shaders de vértice e fragmento, criando um programa de GPU
-void LoadTextureImage(const char* filename); // Função que carrega imagens de textura
+struct TextureLoad;
+void LoadTextureImageAsync(TCarregador* loader, const char* filename, GLuint textureunit); // Agenda a carga de uma imagem de textura
+void UploadTextureImage(TextureLoad* load); // Envia para a GPU uma imagem já decodificada
 
 
 // Declaração de funções utilizadas para pilha de matrizes de modelagem.
@@ -103,10 +128,15 @@ void MouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
 void CursorPosCallback(GLFWwindow* window, double xpos, double ypos);
 void ScrollCallback(GLFWwindow* window, double xoffset, double yoffset);
 
-void drawNumber(int num, double desX,glm::mat4 model, GLint model_uniform);
-void drawNodeValue(int num, glm::mat4 model, GLint model_uniform);
 void renderTree(pNodoA *a, glm::mat4 model, GLint model_uniform, GLint render_as_black_uniform);
-void drawCircle(double x, double y, glm::mat4 model, GLint model_uniform, int num);
+void PreparaInstancias();
+void BuildLabelQuadAndAddToVirtualScene();
+void LoadGlyphAtlas();
+void montaInstancias(pNodoA *a);
+void enviaPosicoes();
+void sincronizaAnimacao();
+void mostraVersao();
+glm::vec4 centroNodo(pNodoA* n, size_t i);
 void updateAll(pNodoA* root);
 GLuint vertex_shader_id;
 GLuint fragment_shader_id;
@@ -117,22 +147,26 @@ GLint projection_uniform;
 GLint object_id_uniform;
 GLint bbox_min_uniform;
 GLint bbox_max_uniform;
+GLint nodos_instanciados_uniform;
+GLint anim_progresso_uniform;
+GLint raio_nodo_uniform;
 
 //convert methods
 float convert_x_to_unit(double x);
 float convert_y_to_unit(double y);
 float convert_radius_to_unit(double r);
-void connectChildren(pNodoA *a);
 
 struct SceneObject
 {
     std::string  name;        // Nome do objeto
-    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
-    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em BuildTrianglesAndAddToVirtualScene()
+    size_t       first_index; // Índice do primeiro vértice dentro do vetor indices[] definido em AddMeshToVirtualScene()
+    size_t       num_indices; // Número de índices do objeto dentro do vetor indices[] definido em AddMeshToVirtualScene()
+    GLint        base_vertex; // Vértice ao qual os índices do objeto são relativos (glDrawElementsBaseVertex)
     GLenum       rendering_mode; // Modo de rasterização (GL_TRIANGLES, GL_TRIANGLE_STRIP, etc.)
     GLuint       vertex_array_object_id; // ID do VAO onde estão armazenados os atributos do modelo
     glm::vec3    bbox_min; // Axis-Aligned Bounding Box do objeto
     glm::vec3    bbox_max;
+    std::vector<TNivelLod> lods; // Níveis de detalhe, com primeiroIndice absoluto; lods[0] é o objeto inteiro
 };
 
 typedef struct
@@ -151,11 +185,18 @@ void createBullet();
 #define N_TIRO 1
 BULLET tiro[N_TIRO];
 // Variável que controla se o texto informativo será mostrado na tela.
-int digitos[2] = {}; //Limitar a dois digitos por conta do tamanho do nodo
 pNodoA *tree = NULL;
-const double EP = 0.1;
-double nodeSpeed = 2.0;
+THistoricoArvore historico;   // versoes da arvore, para desfazer (U) e refazer (R)
+TAnimacao animacao;
+const float DURACAO_ANIMACAO = 0.6f; // segundos para um nodo chegar na nova posicao
+bool animacaoGPU = false;     // tecla G: posicoes interpoladas no vertex shader
+double inicioAnimacao = 0;    // glfwGetTime() do ultimo AnimaArvore()
+GLuint animacao_buffer = 0;   // (x0, y0, dx, dy) por nodo, lido como textura
+GLuint animacao_texture = 0;
+const GLuint UNIDADE_ANIMACAO = 8; // unidade de textura do buffer acima, longe das imagens
+const GLuint UNIDADE_GLIFOS = 9;   // atlas de glifos dos rotulos (glyph_atlas.h)
 double nodeRadius;
+bool layoutArrumado = false; // tecla T: Reingold-Tilford em vez de dividir a largura por nivel
 double nodeRadiusStep = .2;
 double nodeCurrentRadius = 40;
 string inputText;
@@ -165,13 +206,45 @@ const double LIMIT_TREE = 100;
 const double MAX_NODE_RADIUS = 80.0;
 const double MIN_NODE_RADIOUS = 55;
 
-std::map<std::string, SceneObject> g_VirtualScene;
+// Objetos da cena, registrados uma vez com AddVirtualObject(). Cada objeto é
+// referenciado pelo seu handle (índice em g_SceneObjects); o nome só serve
+// para achar o handle, uma vez, com FindVirtualObject().
+std::vector<SceneObject> g_SceneObjects;
+std::map<std::string, int> g_SceneObjectHandles;
+
+// Handles dos objetos desenhados a cada quadro, resolvidos depois do carregamento.
+int g_PlaneObject  = -1;
+int g_LeafObject   = -1;
+int g_SphereObject = -1;
+
+// Vértices e índices de todos os objetos carregados, sob um único VAO.
+TGeometriaEstatica g_StaticGeometry;
+
+// Carga dos recursos em paralelo; g_SceneLoaded fica verdadeiro quando a
+// última termina (OnSceneLoaded()).
+TCarregador g_Loader;
+bool g_SceneLoaded = false;
+
+// Desenhos do quadro, executados de uma vez antes de trocar os buffers.
+TFilaDesenho g_FilaDesenho;
+TItemDesenho ItemObjeto(int handle, GLint objeto, const glm::mat4& modelo, int lod = -1); // Item da fila para um objeto da cena
+
+// Câmera do quadro atual, para escolher o nível de detalhe dos objetos
+// (SelectLod()): quantos pixels uma unidade do mundo ocupa na tela, a uma
+// unidade de distância da câmera (perspectiva) ou a qualquer distância
+// (ortográfica).
+glm::vec4 g_LodCameraPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+float     g_LodPixelsPerUnit  = 1.0f;
+bool      g_LodPerspective    = true;
+#define LOD_PIXEL_ERROR 1.0f // Erro (em pixels) tolerado ao usar um nível mais simples
+int SelectLod(int handle, const glm::vec4& center, float scale); // Nível de detalhe de um objeto com esse centro e escala
 
 // Pilha que guardará as matrizes de modelagem.
 std::stack<glm::mat4>  g_MatrixStack;
 
 // Razão de proporção da janela (largura/altura). Veja função FramebufferSizeCallback().
 float g_ScreenRatio = 1.0f;
+float g_ScreenHeight = WINDOW_HEIGHT; // Altura do framebuffer, em pixels
 
 // Ângulos de Euler que controlam a rotação de um dos cubos da cena virtual
 float g_AngleX = 0.0f;
@@ -324,76 +397,58 @@ int main()
     #define LEAF   4
     #define INATIVE_TIME 10
     #define BRANCH 5
+    #define TEXTO  6
 
     LoadShadersFromFiles();
 
+    IniciaAnimacao(&animacao, DURACAO_ANIMACAO);
+    IniciaHistorico(&historico);
+
     GLint render_as_black_uniform = glGetUniformLocation(program_id, "render_as_black"); // Variável booleana em shader_vertex.glsl
 
-    LoadTextureImage("../../img/wood.jpg");      // TextureImage0
-    LoadTextureImage("../../img/leaf.jpg");      // TextureImage1
-    LoadTextureImage("../../img/tc-earth_daymap_surface.jpg");      // TextureImage2
-
-    ObjModel spheremodel("../../obj/sphere.obj");
-    ComputeNormals(&spheremodel);
-    BuildTrianglesAndAddToVirtualScene(&spheremodel);
-
-    ObjModel branchmodel("../../obj/branch.obj");
-    ComputeNormals(&branchmodel);
-    BuildTrianglesAndAddToVirtualScene(&branchmodel);
-
-    ObjModel leafmodel("../../obj/leaf.obj");
-    ComputeNormals(&leafmodel);
-    BuildTrianglesAndAddToVirtualScene(&leafmodel);
-    // Carregando numeros
-    ObjModel zeromodel("../../obj/zero.obj");
-    ComputeNormals(&zeromodel);
-    BuildTrianglesAndAddToVirtualScene(&zeromodel);
-
-    ObjModel onemodel("../../obj/one.obj");
-    ComputeNormals(&onemodel);
-    BuildTrianglesAndAddToVirtualScene(&onemodel);
-
-    ObjModel twomodel("../../obj/two.obj");
-    ComputeNormals(&twomodel);
-    BuildTrianglesAndAddToVirtualScene(&twomodel);
-
-    ObjModel threemodel("../../obj/three.obj");
-    ComputeNormals(&threemodel);
-    BuildTrianglesAndAddToVirtualScene(&threemodel);
-
-    ObjModel fourmodel("../../obj/four.obj");
-    ComputeNormals(&fourmodel);
-    BuildTrianglesAndAddToVirtualScene(&fourmodel);
-
-    ObjModel fivemodel("../../obj/five.obj");
-    ComputeNormals(&fivemodel);
-    BuildTrianglesAndAddToVirtualScene(&fivemodel);
-
-    ObjModel sixmodel("../../obj/six.obj");
-    ComputeNormals(&sixmodel);
-    BuildTrianglesAndAddToVirtualScene(&sixmodel);
-
-    ObjModel sevenmodel("../../obj/seven.obj");
-    ComputeNormals(&sevenmodel);
-    BuildTrianglesAndAddToVirtualScene(&sevenmodel);
-
-    ObjModel eightmodel("../../obj/eight.obj");
-    ComputeNormals(&eightmodel);
-    BuildTrianglesAndAddToVirtualScene(&eightmodel);
-
-    ObjModel ninemodel("../../obj/nine.obj");
-    ComputeNormals(&ninemodel);
-    BuildTrianglesAndAddToVirtualScene(&ninemodel);
-    
-    ObjModel plane("../../obj/plane.obj");
-    ComputeNormals(&plane);
-    BuildTrianglesAndAddToVirtualScene(&plane);
+    // Imagens e modelos são lidos em paralelo pelas threads de g_Loader; a
+    // thread principal só faz as chamadas OpenGL de cada um, à medida que
+    // ficam prontos (veja o início do loop abaixo). OnSceneLoaded() termina
+    // a cena depois do último.
+    IniciaCarregador(&g_Loader, 0);
+    IniciaGeometriaEstatica(&g_StaticGeometry);
+
+    stbi_set_flip_vertically_on_load(true);
+    LoadTextureImageAsync(&g_Loader, "../../img/wood.jpg", 0);      // TextureImage0
+    LoadTextureImageAsync(&g_Loader, "../../img/leaf.jpg", 1);      // TextureImage1
+    LoadTextureImageAsync(&g_Loader, "../../img/tc-earth_daymap_surface.jpg", 2);      // TextureImage2
+
+    LoadObjAsync(&g_Loader, "../../obj/sphere.obj");
+    LoadObjAsync(&g_Loader, "../../obj/branch.obj");
+    LoadObjAsync(&g_Loader, "../../obj/leaf.obj");
+    LoadObjAsync(&g_Loader, "../../obj/plane.obj");
+    DefineCallbackCargasProntas(&g_Loader, OnSceneLoaded);
+
+    // Rótulos dos nodos: um quadrilátero e um atlas de glifos gerado aqui,
+    // no lugar de um OBJ por dígito.
+    BuildLabelQuadAndAddToVirtualScene();
+    LoadGlyphAtlas();
 
     
 
     // Ficamos em loop, renderizando, até que o usuário feche a janela
     while (!glfwWindowShouldClose(window))
     {
+        // Enquanto os recursos carregam, só enviamos os que ficaram prontos
+        // e mostramos a tela limpa.
+        if (!g_SceneLoaded)
+        {
+            TrataCargasProntas(&g_Loader);
+            if (!g_SceneLoaded)
+            {
+                glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+                continue;
+            }
+        }
+
         addX = 0;
         addY = 0;
         //           R     G     B     A
@@ -488,6 +543,7 @@ int main()
             // Para definição do field of view (FOV), veja slides 205-215 do documento Aula_09_Projecoes.pdf.
             float field_of_view = 3.141592 / 3.0f;
             projection = Matrix_Perspective(field_of_view, g_ScreenRatio, nearplane, farplane);
+            g_LodPixelsPerUnit = 0.5f*g_ScreenHeight / tanf(field_of_view / 2.0f);
         }
         else
         {
@@ -501,7 +557,10 @@ int main()
             float r = t*g_ScreenRatio;
             float l = -r;
             projection = Matrix_Orthographic(l, r, b, t, nearplane, farplane);
+            g_LodPixelsPerUnit = g_ScreenHeight / (t - b);
         }
+        g_LodPerspective = g_UsePerspectiveProjection;
+        g_LodCameraPosition = camera_position_c;
 
         // Enviamos as matrizes "view" e "projection" para a placa de vídeo
         // (GPU). Veja o arquivo "shader_vertex.glsl", onde estas são
@@ -515,9 +574,7 @@ int main()
 
         model = Matrix_Translate(20.0f,-5.0f,0.0f)
               * Matrix_Scale(40.0f, 5.0f, 20.0f);
-        glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-        glUniform1i(object_id_uniform, PLANE);
-        DrawVirtualObject("plane");
+        SubmeteDesenho(&g_FilaDesenho, ItemObjeto(g_PlaneObject, PLANE, model));
 
         model = Matrix_Identity();
         model = model * Matrix_Translate(0.0f, 0.0f, 0.0f);
@@ -537,11 +594,12 @@ int main()
             model = Matrix_Translate(leaf_point.x + addX,leaf_point.y + addY,leaf_point.z + 5.0f)
                   * Matrix_Rotate_X(-90)
                   * Matrix_Scale(0.09f, 0.09f, 0.09f);;
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, NUMBER);
-            DrawVirtualObject("leaf");
+            SubmeteDesenho(&g_FilaDesenho, ItemObjeto(g_LeafObject, NUMBER, model));
         }
 
+        // Tudo o que foi submetido acima vai para a GPU aqui, ordenado por estado.
+        ExecutaFilaDesenho(&g_FilaDesenho);
+
         model = Matrix_Identity();
 
         // Enviamos a nova matriz "model" para a placa de vídeo (GPU). Veja o
@@ -570,166 +628,359 @@ int main()
     return 0;
 }
 
-bool goToPos(pNodoA *a) {
-	
-	double y1 = a->currY;
-	double x1 = a->currX;
-	double dy = (a->y - a->currY);
-	double dx = (a->x - a->currX);
-	double slope = dy / dx;
-
-	if (abs(dy) > nodeSpeed || abs(dx) > nodeSpeed) {
-		if (abs(dy) > abs(dx)) {
-
-			if (a->y > a->currY)
-				a->currY += nodeSpeed;
-			else
-				a->currY -= nodeSpeed;
-
-			if (slope == 0) {
-				a->currX += nodeSpeed;
-			}
-			else
-				a->currX = (a->currY + slope * x1 - y1) / slope;
-
-			if (abs(slope) < EP) {
-				if (a->x > a->currX)
-					a->currX += nodeSpeed;
-				else
-					a->currX -= nodeSpeed;
-			}
-			else {
-				a->currX = (a->currY + slope * x1 - y1) / slope;
-			}
-
-		}
-		else {
-			if (a->x > a->currX)
-				a->currX += nodeSpeed;
-			else
-				a->currX -= nodeSpeed;
-
-			if (abs(slope) < EP) {
-				if(a->y > a->currY)
-					a->currY += nodeSpeed;
-				else
-					a->currY -= nodeSpeed;
-			}
-			else {
-				a->currY = (slope* a->currX - slope * x1 + y1);
-			}
-		}
-		return false;
+// Da nivel e coluna a um nodo, marcando-o como sujo se ele mudou de lugar.
+static void posicionaNodo(pNodoA* n, int level, int col) {
+	if (n->level != level || n->col != col) {
+		n->level = level;
+		n->col = col;
+		n->sujo = true;
 	}
-	else {
-		return true;
-	}
-		
 }
 
-void updatePositions(pNodoA  * currNode, int level, int col, double levelHeight) {
+// Refaz x/y so dos nodos sujos (alterados pela arvore ou que mudaram de
+// nivel/coluna); subarvores limpas sao puladas inteiras. "tudo" refaz todos,
+// para quando levelHeight muda.
+void updatePositions(pNodoA  * currNode, int level, int col, double levelHeight, bool tudo) {
 	if (!currNode) return;
 
-	currNode->level = level;
-	currNode->col = col;
+	posicionaNodo(currNode, level, col);
+
+	// Pre-ordem: cada nodo ja recebeu nivel e coluna do pai quando e' visitado.
+	static TPercurso percurso;
+	IniciaPercurso(&percurso, currNode, PERCURSO_PRE);
+	for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso)) {
+		if (!n->sujo && !tudo) {
+			PulaFilhos(&percurso);
+			continue;
+		}
+		n->sujo = false;
 
-	int absCol = col - pow(2, level - 1) + 1;
+		double ww = ldexp(WINDOW_WIDTH, 1 - n->level); // WINDOW_WIDTH / 2^(level-1)
+		double absCol = n->col - ldexp(1.0, n->level - 1) + 1;
+	    if (ww < 1){
+	        ww = 1.0;
+	    }
 
-	double ww = ((WINDOW_WIDTH) / pow(2, level - 1));
-    if (ww < 1){
-        ww = 1.0;
-    }
+		n->x = ww * (absCol - 1) + ww / 2;
 
-	currNode->x = ww * (absCol - 1) + ww / 2;
 
+		n->y = WINDOW_HEIGHT - (n->level*levelHeight - levelHeight / 2);
 
-	currNode->y = WINDOW_HEIGHT - (level*levelHeight - levelHeight / 2);
-    
-	updatePositions(currNode->esq, level + 1, col << 1, levelHeight);
-	updatePositions(currNode->dir, level + 1, (col << 1)|1, levelHeight);
+		if (n->esq)
+			posicionaNodo(n->esq, n->level + 1, n->col << 1);
+		if (n->dir)
+			posicionaNodo(n->dir, n->level + 1, (n->col << 1)|1);
+	}
 }
-void drawNode(pNodoA *a, glm::mat4 model, GLint model_uniform){
-    a->emPosicao = goToPos(a);
+// Instancias da arvore: cada esfera, galho ou glifo de rotulo e' so' o
+// indice do seu nodo (a pre-ordem de AnimaArvore()) e alguns parametros; o
+// vertex shader busca a posicao do nodo no buffer de posicoes. Uma chamada
+// de desenho por objeto e nivel de detalhe, qualquer que seja o tamanho da
+// arvore.
+struct InstanciaNodo
+{
+    GLint   nodo;
+    GLint   pai;      // galhos: pai do nodo; senao -1
+    GLfloat param[2]; // galhos: (angulo, -); esferas e glifos: (deslocamento em x, escala)
+    GLint   glifo;    // glifos: indice no atlas; senao -1
+};
 
-    connectChildren(a);
-	drawCircle(a->currX, a->currY, model, model_uniform, a->info);
+struct GrupoInstancias
+{
+    const char* objeto;
+    int handle;
+    int niveis;                      // niveis de detalhe do objeto
+    GLuint vao[MAX_NIVEIS_LOD];      // sobre a geometria compartilhada, mais os atributos por instancia
+    GLuint buffer[MAX_NIVEIS_LOD];   // instancias de cada nivel
+    std::vector<InstanciaNodo> dados; // todas, na ordem de montaInstancias()
+    std::vector<InstanciaNodo> porNivel[MAX_NIVEIS_LOD];
+    std::vector<int> nivel;           // nivel de cada instancia no ultimo envio
+    bool sujo;                        // "dados" mudou desde o ultimo envio
+    // Camera, projecao e raio com que "nivel" foi calculado
+    glm::vec4 camera;
+    float pixelsPorUnidade;
+    bool perspectiva;
+    float raio;
 };
 
-void connectChildren(pNodoA *a){
-    float rotate = 2.5f;
-    float scale;
-    if (a->esq) {
-        float scale_y = (convert_y_to_unit(a->currY) - convert_y_to_unit(a->esq->currY))/4;
-        float scale_x = (convert_x_to_unit(a->currX) - convert_x_to_unit(a->esq->currX))/4;
-		if (a->esq->emPosicao) {
-            glm::mat4 model = Matrix_Translate((convert_x_to_unit(a->esq->currX) + convert_x_to_unit(a->currX))/2 ,(convert_y_to_unit(a->esq->currY) + convert_y_to_unit(a->currY))/2,0.0f)
-              * Matrix_Scale(scale_x, scale_y, 0.2f) * Matrix_Rotate_Z(rotate);
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, PLANE);
-            DrawVirtualObject("branch");
-		}
-		
-	}
-	if (a->dir) {
-		if (a->dir->emPosicao) {
-            float scale_y = (convert_y_to_unit(a->currY) - convert_y_to_unit(a->dir->currY))/4;
-            float scale_x = (convert_x_to_unit(a->dir->currX) - convert_x_to_unit(a->currX))/4;
-            glm::mat4 model = Matrix_Translate((convert_x_to_unit(a->dir->currX) + convert_x_to_unit(a->currX))/2 ,(convert_y_to_unit(a->dir->currY) + convert_y_to_unit(a->currY))/2,0.0f)
-              * Matrix_Scale(scale_x, scale_y, 0.2f) * Matrix_Rotate_Z(rotate+1.6);
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, PLANE);
-            DrawVirtualObject("branch");
-		}
-	}
+#define GRUPO_ESFERAS 0
+#define GRUPO_GALHOS  1
+#define GRUPO_ROTULOS 2
+#define NUM_GRUPOS    3
+GrupoInstancias instancias[NUM_GRUPOS] = { {"sphere"}, {"branch"}, {"label"} };
+
+// Cria um VAO por grupo e nivel de detalhe, sobre os buffers de
+// g_StaticGeometry, com o seu buffer de instancias nos atributos 3, 4 e 5 de
+// "shader_vertex.glsl". Sem glDrawElementsInstancedBaseInstance (OpenGL
+// 4.2), o deslocamento das instancias e' estado do VAO. Chamada uma vez,
+// depois da geometria enviada.
+void PreparaInstancias(){
+    for (int g = 0; g < NUM_GRUPOS; g++) {
+        instancias[g].handle = FindVirtualObject(instancias[g].objeto);
+        instancias[g].niveis = instancias[g].handle < 0 ? 0
+                             : min((int) g_SceneObjects[instancias[g].handle].lods.size(), MAX_NIVEIS_LOD);
+        instancias[g].sujo = true;
+        for (int l = 0; l < instancias[g].niveis; l++) {
+            glGenBuffers(1, &instancias[g].buffer[l]);
+            instancias[g].vao[l] = CriaVaoGeometria(&g_StaticGeometry);
+            glBindVertexArray(instancias[g].vao[l]);
+            glBindBuffer(GL_ARRAY_BUFFER, instancias[g].buffer[l]);
+            glVertexAttribIPointer(3, 2, GL_INT, sizeof(InstanciaNodo), (void*) offsetof(InstanciaNodo, nodo));
+            glVertexAttribDivisor(3, 1);
+            glEnableVertexAttribArray(3);
+            glVertexAttribPointer(4, 2, GL_FLOAT, GL_FALSE, sizeof(InstanciaNodo), (void*) offsetof(InstanciaNodo, param));
+            glVertexAttribDivisor(4, 1);
+            glEnableVertexAttribArray(4);
+            glVertexAttribIPointer(5, 1, GL_INT, sizeof(InstanciaNodo), (void*) offsetof(InstanciaNodo, glifo));
+            glVertexAttribDivisor(5, 1);
+            glEnableVertexAttribArray(5);
+        }
+        glBindVertexArray(0);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
 }
-void drawCircle(double x, double y, glm::mat4 model, GLint model_uniform, int num){
-    PushMatrix(model);
-    double r = convert_radius_to_unit(nodeCurrentRadius);
-    model = model * Matrix_Translate(convert_x_to_unit(x),convert_y_to_unit(y), 0.0f) * Matrix_Scale(r,r,r);
-    glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-    glUniform1i(object_id_uniform, SPHERE);
-    DrawVirtualObject("sphere");
-    drawNodeValue(num, model, model_uniform);
-    PopMatrix(model);
-};
 
-void drawNodeValue(int num, glm::mat4 model, GLint model_uniform){
+// Refaz as listas de instancias. So' quando a arvore muda.
+void montaInstancias(pNodoA *a){
+    static TPercurso percurso;
+    float rotate = 2.5f;
+    for (int g = 0; g < NUM_GRUPOS; g++)
+        instancias[g].dados.clear();
+
+    int i = 0;
+    IniciaPercurso(&percurso, a, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso), i++) {
+        InstanciaNodo esfera = { i, -1, {0.0f, 1.0f}, -1 };
+        instancias[GRUPO_ESFERAS].dados.push_back(esfera);
+        if (n->esq) {
+            InstanciaNodo galho = { i + 1, i, {rotate, 0.0f}, -1 };
+            instancias[GRUPO_GALHOS].dados.push_back(galho);
+        }
+        if (n->dir) {
+            InstanciaNodo galho = { i + 1 + tamanhoArvore(n->esq), i, {rotate + 1.6f, 0.0f}, -1 };
+            instancias[GRUPO_GALHOS].dados.push_back(galho);
+        }
 
-    if (num < 10){
-        drawNumber(num, 0.0f,model, model_uniform);
-    } else{
-        int secondDigit = num/10;
-        int firstDigit = num - secondDigit * 10;
-        drawNumber(secondDigit, -0.4f,model, model_uniform);
-        drawNumber(firstDigit, 0.4f, model, model_uniform);
+        // Glifos lado a lado, 0.8 de distancia, centrados na esfera. Com
+        // mais de dois, encolhem para caber na largura de dois.
+        char texto[16];
+        int nc = snprintf(texto, sizeof(texto), "%d", n->info);
+        float escala = nc > 2 ? 2.0f / nc : 1.0f;
+        for (int k = 0; k < nc; k++) {
+            InstanciaNodo glifo = { i, -1, {(k - (nc - 1) / 2.0f) * 0.8f * escala, escala}, GlifoAtlas(texto[k]) };
+            instancias[GRUPO_ROTULOS].dados.push_back(glifo);
+        }
     }
+
+    for (int g = 0; g < NUM_GRUPOS; g++)
+        instancias[g].sujo = true;
 }
 
-void drawNumber(int num, double desX,glm::mat4 model, GLint model_uniform){
-    char *filenames[10] = {"zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine"};
-    model = model * Matrix_Translate(desX, 0.0f, 1.2f)
-                  * Matrix_Rotate_X(-90)
-                  * Matrix_Scale(0.09f, 0.09f, 0.09f);
-    glUniformMatrix4fv(model_uniform, 1 , GL_FALSE , glm::value_ptr(model));
-    glUniform1i(object_id_uniform, NUMBER);
-    DrawVirtualObject(filenames[num]);
+// Destino do nodo i (a pre-ordem de AnimaArvore()) no mundo. Serve para o
+// nivel de detalhe, que nao precisa acompanhar a animacao.
+glm::vec4 destinoNodo(int i){
+    if (i < 0 || (size_t) i >= animacao.nodos.size())
+        return glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    return glm::vec4(convert_x_to_unit(animacao.x0[i] + animacao.dx[i]),
+                     convert_y_to_unit(animacao.y0[i] + animacao.dy[i]), 0.0f, 1.0f);
+}
+
+// Escolhe o nivel de detalhe de cada instancia pelo tamanho do seu nodo (ou
+// galho) na tela e separa as instancias por nivel. Os niveis so' sao
+// recalculados quando a arvore, a camera, a projecao ou o raio dos nodos
+// mudam, entao quadros parados custam O(1); os buffers so' sao reenviados
+// quando a arvore muda ou alguma instancia troca de nivel.
+void enviaInstancias(GrupoInstancias* grupo){
+    float raio = convert_radius_to_unit(nodeCurrentRadius);
+    if (!grupo->sujo && grupo->camera == g_LodCameraPosition && grupo->pixelsPorUnidade == g_LodPixelsPerUnit
+        && grupo->perspectiva == g_LodPerspective && grupo->raio == raio)
+        return;
+    grupo->camera = g_LodCameraPosition;
+    grupo->pixelsPorUnidade = g_LodPixelsPerUnit;
+    grupo->perspectiva = g_LodPerspective;
+    grupo->raio = raio;
+
+    size_t n = grupo->dados.size();
+    bool mudou = grupo->sujo;
+    grupo->nivel.resize(n, 0);
+    for (size_t i = 0; i < n && grupo->niveis > 1; i++) {
+        const InstanciaNodo& d = grupo->dados[i];
+        glm::vec4 centro = destinoNodo(d.nodo);
+        float escala = raio * d.param[1];
+        if (d.pai >= 0) {
+            // mesma escala do galho em "shader_vertex.glsl"
+            glm::vec4 pai = destinoNodo(d.pai);
+            escala = max(max(fabsf(pai.x - centro.x), fabsf(pai.y - centro.y)) / 4.0f, 0.2f);
+            centro = (centro + pai) / 2.0f;
+        }
+        int nivel = SelectLod(grupo->handle, centro, escala);
+        if (nivel != grupo->nivel[i]) {
+            grupo->nivel[i] = nivel;
+            mudou = true;
+        }
+    }
+    if (!mudou)
+        return;
+
+    for (int l = 0; l < grupo->niveis; l++)
+        grupo->porNivel[l].clear();
+    for (size_t i = 0; i < n; i++)
+        grupo->porNivel[min(grupo->nivel[i], grupo->niveis - 1)].push_back(grupo->dados[i]);
+    for (int l = 0; l < grupo->niveis; l++) {
+        glBindBuffer(GL_ARRAY_BUFFER, grupo->buffer[l]);
+        glBufferData(GL_ARRAY_BUFFER, grupo->porNivel[l].size() * sizeof(InstanciaNodo),
+                     grupo->porNivel[l].data(), GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    grupo->sujo = false;
 }
 
 void renderTree(pNodoA *a, glm::mat4 model, GLint model_uniform, GLint render_as_black_uniform){
-    if (!a) return;
-    // Tentiva de evitar sobreposicao de blocos
-    drawNode(a, model, model_uniform);
-    renderTree(a->esq, model, model_uniform, render_as_black_uniform);
-    renderTree(a->dir, model, model_uniform, render_as_black_uniform);
+    // Uniforms lidos so' com nodos_instanciados ligado; valem ate' a fila executar.
+    glUniform1f(anim_progresso_uniform, animacaoGPU ? (glfwGetTime() - inicioAnimacao) / DURACAO_ANIMACAO : 0.0f);
+    glUniform1f(raio_nodo_uniform, convert_radius_to_unit(nodeCurrentRadius));
+
+    // Rotulos na frente da esfera; a borda suave do glifo e' misturada com
+    // o que ja foi desenhado, e o quadrilatero aparece dos dois lados.
+    static const GLint objetos[NUM_GRUPOS] = { SPHERE, PLANE, TEXTO };
+    glm::mat4 rotulo = model * Matrix_Translate(0.0f, 0.0f, 1.2f);
+    for (int g = 0; g < NUM_GRUPOS; g++) {
+        enviaInstancias(&instancias[g]);
+        for (int l = 0; l < instancias[g].niveis; l++) {
+            if (instancias[g].porNivel[l].empty())
+                continue;
+            TItemDesenho item = ItemObjeto(instancias[g].handle, objetos[g], g == GRUPO_ROTULOS ? rotulo : model, l);
+            item.vao = instancias[g].vao[l];
+            item.instanciado = true;
+            item.instancias = instancias[g].porNivel[l].size();
+            item.mistura = g == GRUPO_ROTULOS;
+            SubmeteDesenho(&g_FilaDesenho, item);
+        }
+    }
+}
+
+// Envia a posicao de cada nodo para a GPU, como (x0, y0, dx, dy). Com a
+// animacao na GPU e' a partida e o deslocamento, enviados uma vez por
+// layout. Na CPU e' a posicao atual e o que falta andar (zero para quem
+// chegou), reenviados a cada quadro so' enquanto algo se move.
+void enviaPosicoes(){
+    static std::vector<float> dados;
+    size_t n = animacao.nodos.size();
+    dados.resize(4 * n);
+    for (size_t i = 0; i < n; i++) {
+        if (animacaoGPU) {
+            dados[4*i + 0] = animacao.x0[i];
+            dados[4*i + 1] = animacao.y0[i];
+            dados[4*i + 2] = animacao.dx[i];
+            dados[4*i + 3] = animacao.dy[i];
+        }
+        else {
+            bool chegou = animacao.t[i] >= 1.0f;
+            dados[4*i + 0] = animacao.x[i];
+            dados[4*i + 1] = animacao.y[i];
+            dados[4*i + 2] = chegou ? 0.0f : animacao.x0[i] + animacao.dx[i] - animacao.x[i];
+            dados[4*i + 3] = chegou ? 0.0f : animacao.y0[i] + animacao.dy[i] - animacao.y[i];
+        }
+    }
+
+    if (animacao_buffer == 0) {
+        glGenBuffers(1, &animacao_buffer);
+        glGenTextures(1, &animacao_texture);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, animacao_buffer);
+    glBufferData(GL_TEXTURE_BUFFER, dados.size() * sizeof(float), dados.data(), GL_STREAM_DRAW);
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_ANIMACAO);
+    glBindTexture(GL_TEXTURE_BUFFER, animacao_texture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, animacao_buffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+// Com a animacao na GPU, currX/currY so' sao atualizados quando a CPU
+// precisa deles: antes de alterar a arvore (para que a proxima animacao
+// parta de onde os nodos estao na tela).
+void sincronizaAnimacao(){
+    if (animacaoGPU)
+        PosicionaAnimacao(&animacao, glfwGetTime() - inicioAnimacao);
+}
+
+// Centro na tela do nodo n, o i-esimo na pre-ordem. Com a animacao na GPU,
+// so' este nodo e' calculado: as colisoes nao sincronizam a arvore toda.
+glm::vec4 centroNodo(pNodoA* n, size_t i){
+    float x = (float) n->currX, y = (float) n->currY;
+    if (animacaoGPU && !animacao.parado && animacao.geracao == GeracaoArvore()
+        && i < animacao.nodos.size() && animacao.nodos[i] == n)
+        PosicaoAnimacao(&animacao, i, glfwGetTime() - inicioAnimacao, &x, &y);
+    return glm::vec4(convert_x_to_unit(x), convert_y_to_unit(y), 0.0f, 0.0f);
+}
+
+// Troca a arvore desenhada por uma copia da versao atual do historico. As
+// versoes sao so' de leitura, e a copia pode ser posicionada e animada; os
+// nodos que continuam na arvore partem de onde estao na tela.
+void mostraVersao(){
+    static TPercurso percurso;
+    sincronizaAnimacao();
+    pNodoA* nova = CopiaVersao(PoolArvore(), VersaoAtual(&historico));
+    IniciaPercurso(&percurso, nova, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso)) {
+        pNodoA* antigo = consultaABP(tree, n->info);
+        if (antigo) {
+            n->currX = antigo->currX;
+            n->currY = antigo->currY;
+        }
+    }
+    LiberaArvore(tree);
+    // As versoes sao AVL; a rubro-negra precisa das cores.
+    tree = ModoArvore() == ARVORE_RN ? ReconstroiArvore(nova) : nova;
+    printf("Versao %zu de %zu: %d nodos\n", historico.atual, historico.versoes.size() - 1, tamanhoArvore(tree));
 }
 
 void updateAll(pNodoA* root){
-    int levels = getLevel(root);
+    // O layout so e' refeito quando a arvore muda; quadros parados nao custam nada.
+    static unsigned long geracao = 0;
+    static int ultimosNiveis = 0;
+    static bool ultimoLayout = false;
+    static bool ultimoGPU = false;
+    int levels = alturaArvore(root);
     double levelHeight = WINDOW_HEIGHT / levels;
-    updatePositions(root,1,1, levelHeight);
-    nodeRadius = min(
+    double agora = glfwGetTime();
+    if (GeracaoArvore() != geracao || layoutArrumado != ultimoLayout || animacaoGPU != ultimoGPU) {
+        sincronizaAnimacao();
+        // O raio na tela e' nodeRadius*100/150 (convert_radius_to_unit), entao
+        // 1.5*MAX_NODE_RADIUS pixels de separacao evitam que esferas se toquem.
+        if (layoutArrumado)
+            LayoutArrumado(root, WINDOW_WIDTH, WINDOW_HEIGHT, 1.5 * MAX_NODE_RADIUS);
+        else
+            updatePositions(root,1,1, levelHeight, levels != ultimosNiveis || layoutArrumado != ultimoLayout);
+        geracao = GeracaoArvore();
+        ultimosNiveis = levels;
+        ultimoLayout = layoutArrumado;
+        ultimoGPU = animacaoGPU;
+        AnimaArvore(&animacao, root);
+        inicioAnimacao = agora;
+        montaInstancias(root);
+        enviaPosicoes();
+    }
+
+    // Passo da animacao pelo tempo real desde o ultimo quadro. Limitado para
+    // que uma pausa longa (arvore vazia, janela arrastada) nao pule a animacao.
+    // Na GPU, a CPU so' grava a posicao final, uma vez, quando todos chegam.
+    static double ultimoQuadro = agora;
+    if (!animacaoGPU) {
+        if (!animacao.parado) {
+            AvancaAnimacao(&animacao, (float) min(agora - ultimoQuadro, 0.1));
+            enviaPosicoes();
+        }
+    }
+    else if (!animacao.parado && agora - inicioAnimacao >= DURACAO_ANIMACAO)
+        PosicionaAnimacao(&animacao, DURACAO_ANIMACAO);
+    ultimoQuadro = agora;
+    if (layoutArrumado) {
+        nodeRadius = min(((WINDOW_HEIGHT / levels) / 2)*0.8, MAX_NODE_RADIUS);
+    } else {
+        nodeRadius = min(
 		min(((WINDOW_WIDTH / pow(2, levels)*1.0) / 2)*0.8, ((WINDOW_HEIGHT / levels) / 2)*0.8)
 		, MAX_NODE_RADIUS);
+    }
 	nodeRadius = max(nodeRadius, MIN_NODE_RADIOUS);
 
     if (abs(nodeRadius - nodeCurrentRadius) > nodeRadiusStep) {
@@ -762,9 +1013,7 @@ void drawBullets(glm::mat4 model, GLint model_uniform, GLint render_as_black_uni
             tiro[j].na_tela = bulletLimit(tiro[j]);
             tiro[j].pos_z = tiro[j].pos_z - tiro[j].velocidade;
             model = Matrix_Translate(tiro[j].pos_x, tiro[j].pos_y, tiro[j].pos_z) * Matrix_Scale(0.10f, 0.10f, 0.10f);
-            glUniformMatrix4fv(model_uniform, 1, GL_FALSE, glm::value_ptr(model));
-            glUniform1i(object_id_uniform, SPHERE);
-            DrawVirtualObject("sphere");
+            SubmeteDesenho(&g_FilaDesenho, ItemObjeto(g_SphereObject, SPHERE, model));
         }
     }
 }
@@ -779,30 +1028,35 @@ float convert_radius_to_unit(double r){
 }
 
 void colision_tree(pNodoA* root, float x_tiro, float y_tiro, float z_tiro, int index_tiro){
-    if (root == NULL)
-        return;
-
-    float x_node = convert_x_to_unit(root->currX);
-    float y_node = convert_y_to_unit(root->currY);
-    float z_node = 0;
+    static TPercurso percurso;
     double r = convert_radius_to_unit(nodeCurrentRadius);
-    glm::vec4 sphere = glm::vec4(convert_x_to_unit(root->currX), convert_y_to_unit(root->currY),0.0f, 0.0f);
     glm::vec4 bullet = glm::vec4(x_tiro, y_tiro,z_tiro, 0.0f);
-    if(hasSphereSphereCollision(sphere, r, bullet, 0.10f)){
-        tree = RemoveArvore(tree, root->info);
-        tiro[index_tiro].na_tela = false;
-        return;
+
+    size_t i = 0;
+    IniciaPercurso(&percurso, root, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso), i++) {
+        glm::vec4 sphere = centroNodo(n, i);
+        if(hasSphereSphereCollision(sphere, r, bullet, 0.10f)){
+            // A remoção altera a árvore: paramos o percurso aqui.
+            sincronizaAnimacao();
+            HistoricoRemove(&historico, n->info);
+            tree = RemoveArvore(tree, n->info);
+            tiro[index_tiro].na_tela = false;
+            return;
+        }
     }
-    colision_tree(root->esq, x_tiro, y_tiro, z_tiro, index_tiro);
-    colision_tree(root->dir, x_tiro, y_tiro, z_tiro, index_tiro);
 }
 bool cameraTreeColision(pNodoA* root,glm::vec4 point){
-    if(!root){return false;}
-    glm::vec4 sphere = glm::vec4(convert_x_to_unit(root->currX), convert_y_to_unit(root->currY),0.0f, 0.0f);
-    if(hasSphereBulletCollision(sphere, convert_radius_to_unit(nodeCurrentRadius), point)){
-        return true;
+    static TPercurso percurso;
+    size_t i = 0;
+    IniciaPercurso(&percurso, root, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso), i++) {
+        glm::vec4 sphere = centroNodo(n, i);
+        if(hasSphereBulletCollision(sphere, convert_radius_to_unit(nodeCurrentRadius), point)){
+            return true;
+        }
     }
-    return cameraTreeColision(root->esq, point) || cameraTreeColision(root->dir, point);
+    return false;
 }
 void bulletsHit(){
     for(int j=0; j<N_TIRO; j++)
@@ -840,74 +1094,49 @@ void ComputeNormals(ObjModel* model)
     // Primeiro computamos as normais para todos os TRIÂNGULOS.
     // Segundo, computamos as normais dos VÉRTICES através do método proposto
     // por Gouraud, onde a normal de cada vértice vai ser a média das normais de
-    // todas as faces que compartilham este vértice.
+    // todas as faces que compartilham este vértice. As duas etapas rodam em
+    // paralelo e com SSE em CalculaNormaisVertices() (vertex_normals.h).
 
     size_t num_vertices = model->attrib.vertices.size() / 3;
 
-    std::vector<int> num_triangles_per_vertex(num_vertices, 0);
-    std::vector<glm::vec4> vertex_normals(num_vertices, glm::vec4(0.0f,0.0f,0.0f,0.0f));
-
+    std::vector<int> triangles;
     for (size_t shape = 0; shape < model->shapes.size(); ++shape)
     {
-        size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
+        tinyobj::mesh_t& mesh = model->shapes[shape].mesh;
+        size_t num_triangles = mesh.num_face_vertices.size();
 
         for (size_t triangle = 0; triangle < num_triangles; ++triangle)
         {
-            assert(model->shapes[shape].mesh.num_face_vertices[triangle] == 3);
+            assert(mesh.num_face_vertices[triangle] == 3);
 
-            glm::vec4  vertices[3];
             for (size_t vertex = 0; vertex < 3; ++vertex)
             {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
-                const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
-                const float vz = model->attrib.vertices[3*idx.vertex_index + 2];
-                vertices[vertex] = glm::vec4(vx,vy,vz,1.0);
-            }
-
-            const glm::vec4  a = vertices[0];
-            const glm::vec4  b = vertices[1];
-            const glm::vec4  c = vertices[2];
-
-            const glm::vec4  n = crossproduct(b-a,c-a);
-
-            for (size_t vertex = 0; vertex < 3; ++vertex)
-            {
-                tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
-                num_triangles_per_vertex[idx.vertex_index] += 1;
-                vertex_normals[idx.vertex_index] += n;
-                model->shapes[shape].mesh.indices[3*triangle + vertex].normal_index = idx.vertex_index;
+                tinyobj::index_t& idx = mesh.indices[3*triangle + vertex];
+                triangles.push_back(idx.vertex_index);
+                idx.normal_index = idx.vertex_index;
             }
         }
     }
 
-    model->attrib.normals.resize( 3*num_vertices );
-
-    for (size_t i = 0; i < vertex_normals.size(); ++i)
-    {
-        glm::vec4 n = vertex_normals[i] / (float)num_triangles_per_vertex[i];
-        n /= norm(n);
-        model->attrib.normals[3*i + 0] = n.x;
-        model->attrib.normals[3*i + 1] = n.y;
-        model->attrib.normals[3*i + 2] = n.z;
-    }
+    CalculaNormaisVertices(model->attrib.vertices.data(), num_vertices, triangles, &model->attrib.normals);
 }
 
-// Constrói triângulos para futura renderização a partir de um ObjModel.
-void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
+// Constrói os triângulos de cada shape de um ObjModel, já no formato que vai
+// para a GPU (e para a cache de malhas). Não usa OpenGL.
+void CookObjModel(ObjModel* model, std::vector<TObjetoCozido>& objects)
 {
-    GLuint vertex_array_object_id;
-    glGenVertexArrays(1, &vertex_array_object_id);
-    glBindVertexArray(vertex_array_object_id);
-
-    std::vector<GLuint> indices;
-    std::vector<float>  model_coefficients;
-    std::vector<float>  normal_coefficients;
-    std::vector<float>  texture_coefficients;
-
     for (size_t shape = 0; shape < model->shapes.size(); ++shape)
     {
-        size_t first_index = indices.size();
+        objects.push_back(TObjetoCozido());
+        TObjetoCozido& cooked = objects.back();
+        cooked.nome = model->shapes[shape].name;
+
+        TMalha& malha = cooked.malha;
+        std::vector<GLuint>& indices              = malha.indices;
+        std::vector<float>&  model_coefficients   = malha.posicoes;
+        std::vector<float>&  normal_coefficients  = malha.normais;
+        std::vector<float>&  texture_coefficients = malha.texcoords;
+
         size_t num_triangles = model->shapes[shape].mesh.num_face_vertices.size();
 
         const float minval = std::numeric_limits<float>::min();
@@ -924,7 +1153,7 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
             {
                 tinyobj::index_t idx = model->shapes[shape].mesh.indices[3*triangle + vertex];
 
-                indices.push_back(first_index + 3*triangle + vertex);
+                indices.push_back(3*triangle + vertex);
 
                 const float vx = model->attrib.vertices[3*idx.vertex_index + 0];
                 const float vy = model->attrib.vertices[3*idx.vertex_index + 1];
@@ -968,103 +1197,300 @@ void BuildTrianglesAndAddToVirtualScene(ObjModel* model)
             }
         }
 
-        size_t last_index = indices.size() - 1;
+        // No buffer compartilhado todo vértice tem os três atributos; se a
+        // shape não tem normais ou coordenadas de textura, vão zeros.
+        size_t num_vertices = model_coefficients.size() / 4;
+        if (normal_coefficients.size() != 4*num_vertices)
+            normal_coefficients.clear();
+        if (texture_coefficients.size() != 2*num_vertices)
+            texture_coefficients.clear();
+
+        // Até aqui, um vértice por índice. Juntamos os vértices iguais e
+        // reordenamos triângulos e vértices para a cache da GPU.
+        TRelatorioMalha relatorio = OtimizaMalha(&malha);
+        printf("Malha \"%s\": %zu -> %zu vertices, ACMR %.3f -> %.3f\n",
+               model->shapes[shape].name.c_str(), relatorio.verticesAntes, relatorio.verticesDepois,
+               relatorio.acmrSoldada, relatorio.acmrOtimizada);
+
+        // Níveis de detalhe, escolhidos a cada quadro por SelectLod().
+        GeraNiveisLod(&malha, &cooked.niveis);
+        for (size_t lod = 1; lod < cooked.niveis.size(); ++lod)
+            printf("  LOD %zu: %u triangulos, erro %g\n", lod, cooked.niveis[lod].numIndices / 3, cooked.niveis[lod].erro);
+
+        memcpy(cooked.bboxMin, glm::value_ptr(bbox_min), sizeof(cooked.bboxMin));
+        memcpy(cooked.bboxMax, glm::value_ptr(bbox_max), sizeof(cooked.bboxMax));
+    }
+}
 
-        SceneObject theobject;
-        theobject.name           = model->shapes[shape].name;
-        theobject.first_index    = first_index; // Primeiro índice
-        theobject.num_indices    = last_index - first_index + 1; // Número de indices
-        theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
-        theobject.vertex_array_object_id = vertex_array_object_id;
-        theobject.bbox_min = bbox_min;
-        theobject.bbox_max = bbox_max;
+// Acrescenta uma malha pronta a g_StaticGeometry e a registra na cena. Os
+// buffers só são enviados para a GPU em EnviaGeometriaEstatica(), depois de
+// todos os modelos lidos. "indices" traz todos os níveis de detalhe, descritos
+// em "lods" (sem níveis, o objeto é todos os índices).
+void AddMeshToVirtualScene(const std::string& name, const float* positions, const float* normals,
+                           const float* texcoords, size_t num_vertices, const GLuint* indices,
+                           size_t num_indices, const TNivelLod* lods, size_t num_lods,
+                           const float* bbox_min, const float* bbox_max)
+{
+    TTrechoGeometria trecho = AcrescentaMalha(&g_StaticGeometry, positions, normals, texcoords,
+                                              num_vertices, indices, num_indices);
 
-        g_VirtualScene[model->shapes[shape].name] = theobject;
+    SceneObject theobject;
+    theobject.name           = name;
+    for (size_t i = 0; i < num_lods; ++i)
+    {
+        TNivelLod lod = lods[i];
+        lod.primeiroIndice += trecho.primeiroIndice;
+        theobject.lods.push_back(lod);
+    }
+    if (theobject.lods.empty())
+    {
+        TNivelLod lod = { (unsigned int) trecho.primeiroIndice, (unsigned int) trecho.numIndices, 0.0f };
+        theobject.lods.push_back(lod);
     }
+    theobject.first_index    = theobject.lods[0].primeiroIndice; // Primeiro índice
+    theobject.num_indices    = theobject.lods[0].numIndices; // Número de indices do nível mais detalhado
+    theobject.base_vertex    = trecho.verticeBase;
+    theobject.rendering_mode = GL_TRIANGLES;       // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
+    theobject.vertex_array_object_id = g_StaticGeometry.vao;
+    theobject.bbox_min = glm::make_vec3(bbox_min);
+    theobject.bbox_max = glm::make_vec3(bbox_max);
+
+    AddVirtualObject(theobject, name);
+}
 
-    GLuint VBO_model_coefficients_id;
-    glGenBuffers(1, &VBO_model_coefficients_id);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO_model_coefficients_id);
-    glBufferData(GL_ARRAY_BUFFER, model_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, model_coefficients.size() * sizeof(float), model_coefficients.data());
-    GLuint location = 0; // "(location = 0)" em "shader_vertex.glsl"
-    GLint  number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-    glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-    glEnableVertexAttribArray(location);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+// Registra na cena os objetos produzidos por CookObjModel().
+void AddCookedObjectsToVirtualScene(const std::vector<TObjetoCozido>& objects)
+{
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        const TMalha& m = objects[i].malha;
+        AddMeshToVirtualScene(objects[i].nome, m.posicoes.data(),
+                              m.normais.empty() ? NULL : m.normais.data(),
+                              m.texcoords.empty() ? NULL : m.texcoords.data(),
+                              NumVerticesMalha(m), m.indices.data(), m.indices.size(),
+                              objects[i].niveis.data(), objects[i].niveis.size(),
+                              objects[i].bboxMin, objects[i].bboxMax);
+    }
+}
 
-    if ( !normal_coefficients.empty() )
+// Um OBJ sendo carregado pelo g_Loader (LoadObjAsync()).
+struct ObjLoad
+{
+    std::string                filename;
+    bool                       from_cache;
+    TCacheMalhas               cache;
+    std::vector<TObjetoCozido> objects;
+};
+
+// Parte da carga de um OBJ que não usa OpenGL, feita numa thread do
+// carregador. O resultado de CookObjModel() fica numa cache binária ao lado
+// do arquivo ("<arquivo>.cozido"); enquanto o OBJ não mudar, as próximas
+// execuções leem a cache direto, sem tinyobj, ComputeNormals(), OtimizaMalha()
+// nem GeraNiveisLod().
+void CookOrLoadCachedObj(ObjLoad* load)
+{
+    const char* filename = load->filename.c_str();
+
+    TArquivoMapeado source;
+    if (!MapeiaArquivo(filename, &source))
     {
-        GLuint VBO_normal_coefficients_id;
-        glGenBuffers(1, &VBO_normal_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_normal_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, normal_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, normal_coefficients.size() * sizeof(float), normal_coefficients.data());
-        location = 1; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 4; // vec4 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        fprintf(stderr, "ERROR: Cannot open model file \"%s\".\n", filename);
+        std::exit(EXIT_FAILURE);
     }
+    unsigned long long hash = HashDados(source.dados, source.tamanho);
+    DesmapeiaArquivo(&source);
+
+    std::string cache_path = load->filename + ".cozido";
+    load->from_cache = AbreCacheMalhas(cache_path.c_str(), hash, &load->cache);
+    if (load->from_cache)
+        return;
 
-    if ( !texture_coefficients.empty() )
+    try
     {
-        GLuint VBO_texture_coefficients_id;
-        glGenBuffers(1, &VBO_texture_coefficients_id);
-        glBindBuffer(GL_ARRAY_BUFFER, VBO_texture_coefficients_id);
-        glBufferData(GL_ARRAY_BUFFER, texture_coefficients.size() * sizeof(float), NULL, GL_STATIC_DRAW);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, texture_coefficients.size() * sizeof(float), texture_coefficients.data());
-        location = 2; // "(location = 1)" em "shader_vertex.glsl"
-        number_of_dimensions = 2; // vec2 em "shader_vertex.glsl"
-        glVertexAttribPointer(location, number_of_dimensions, GL_FLOAT, GL_FALSE, 0, 0);
-        glEnableVertexAttribArray(location);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        ObjModel model(filename);
+        ComputeNormals(&model);
+        CookObjModel(&model, load->objects);
+    }
+    catch (const std::exception& e)
+    {
+        fprintf(stderr, "ERROR: %s (\"%s\")\n", e.what(), filename);
+        std::exit(EXIT_FAILURE);
     }
+    if (!GravaCacheMalhas(cache_path.c_str(), hash, load->objects))
+        fprintf(stderr, "Nao foi possivel gravar a cache \"%s\".\n", cache_path.c_str());
+}
 
-    GLuint indices_id;
-    glGenBuffers(1, &indices_id);
+// Parte da carga que registra as shapes na cena, na thread do OpenGL.
+void AddLoadedObjToVirtualScene(ObjLoad* load)
+{
+    if (load->from_cache)
+    {
+        for (size_t i = 0; i < load->cache.objetos.size(); ++i)
+        {
+            const TVistaCozida& v = load->cache.objetos[i];
+            AddMeshToVirtualScene(std::string(v.nome, v.tamanhoNome), v.posicoes, v.normais, v.texcoords,
+                                  v.numVertices, v.indices, v.numIndices, v.niveis, v.numNiveis,
+                                  v.bboxMin, v.bboxMax);
+        }
+        FechaCacheMalhas(&load->cache);
+    }
+    else
+    {
+        AddCookedObjectsToVirtualScene(load->objects);
+        load->objects.clear();
+    }
+}
 
-    // "Ligamos" o buffer. Note que o tipo agora é GL_ELEMENT_ARRAY_BUFFER.
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint), NULL, GL_STATIC_DRAW);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indices.size() * sizeof(GLuint), indices.data());
-    // glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0); // XXX Errado!
-    //
+void LoadObjAsync(TCarregador* loader, const char* filename)
+{
+    std::shared_ptr<ObjLoad> load(new ObjLoad());
+    load->filename = filename;
+    load->from_cache = false;
+    AgendaCarga(loader, filename,
+                [load]() { CookOrLoadCachedObj(load.get()); },
+                [load]() { AddLoadedObjToVirtualScene(load.get()); });
+}
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+// Todas as cargas terminaram: a geometria vai para a GPU e os objetos
+// desenhados a cada quadro são resolvidos.
+void OnSceneLoaded()
+{
+    EnviaGeometriaEstatica(&g_StaticGeometry);
+
+    g_PlaneObject  = FindVirtualObject("plane");
+    g_LeafObject   = FindVirtualObject("leaf");
+    g_SphereObject = FindVirtualObject("sphere");
+    PreparaInstancias();
+
+    ImprimeRelatorioCargas(&g_Loader);
+    EncerraCarregador(&g_Loader);
+    g_SceneLoaded = true;
 }
 
-void DrawVirtualObject(const char* object_name)
+// Registra um objeto na cena. Registrar de novo o mesmo nome substitui o
+// objeto, mantendo o handle.
+int AddVirtualObject(const SceneObject& object, const std::string& key)
 {
-    // "Ligamos" o VAO. Informamos que queremos utilizar os atributos de
-    // vértices apontados pelo VAO criado pela função BuildTrianglesAndAddToVirtualScene(). Veja
-    // comentários detalhados dentro da definição de BuildTrianglesAndAddToVirtualScene().
-    glBindVertexArray(g_VirtualScene[object_name].vertex_array_object_id);
-
-    // Setamos as variáveis "bbox_min" e "bbox_max" do fragment shader
-    // com os parâmetros da axis-aligned bounding box (AABB) do modelo.
-    glm::vec3 bbox_min = g_VirtualScene[object_name].bbox_min;
-    glm::vec3 bbox_max = g_VirtualScene[object_name].bbox_max;
-    glUniform4f(bbox_min_uniform, bbox_min.x, bbox_min.y, bbox_min.z, 1.0f);
-    glUniform4f(bbox_max_uniform, bbox_max.x, bbox_max.y, bbox_max.z, 1.0f);
+    std::map<std::string, int>::iterator it = g_SceneObjectHandles.find(key);
+    if (it != g_SceneObjectHandles.end())
+    {
+        g_SceneObjects[it->second] = object;
+        return it->second;
+    }
+    int handle = (int) g_SceneObjects.size();
+    g_SceneObjects.push_back(object);
+    g_SceneObjectHandles[key] = handle;
+    return handle;
+}
 
-    // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
-    // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene[""] dentro da função BuildTrianglesAndAddToVirtualScene(), e veja
-    // a documentação da função glDrawElements() em
-    // http://docs.gl/gl3/glDrawElements.
-    glDrawElements(
-        g_VirtualScene[object_name].rendering_mode,
-        g_VirtualScene[object_name].num_indices,
-        GL_UNSIGNED_INT,
-        (void*)(g_VirtualScene[object_name].first_index * sizeof(GLuint))
-    );
+int FindVirtualObject(const char* key)
+{
+    std::map<std::string, int>::iterator it = g_SceneObjectHandles.find(key);
+    if (it == g_SceneObjectHandles.end())
+    {
+        fprintf(stderr, "ERROR: Scene object \"%s\" not found.\n", key);
+        return -1;
+    }
+    return it->second;
+}
 
-    // "Desligamos" o VAO, evitando assim que operações posteriores venham a
-    // alterar o mesmo. Isso evita bugs.
-    glBindVertexArray(0);
+// Quadrilátero dos rótulos dos nodos, do tamanho de um glifo (0.8 x 1.2
+// no espaço da esfera de raio 1), com coordenadas de textura de 0 a 1.
+void BuildLabelQuadAndAddToVirtualScene()
+{
+    GLfloat model_coefficients[] = {
+        -0.4f, -0.6f, 0.0f, 1.0f,
+         0.4f, -0.6f, 0.0f, 1.0f,
+         0.4f,  0.6f, 0.0f, 1.0f,
+        -0.4f,  0.6f, 0.0f, 1.0f,
+    };
+    GLfloat texture_coefficients[] = {
+        0.0f, 0.0f,
+        1.0f, 0.0f,
+        1.0f, 1.0f,
+        0.0f, 1.0f,
+    };
+    GLuint indices[] = { 0, 1, 2, 0, 2, 3 };
+
+    TTrechoGeometria trecho = AcrescentaMalha(&g_StaticGeometry, model_coefficients, NULL,
+                                              texture_coefficients, 4, indices, 6);
+
+    SceneObject theobject;
+    theobject.name           = "label";
+    theobject.first_index    = trecho.primeiroIndice;
+    theobject.num_indices    = trecho.numIndices;
+    theobject.base_vertex    = trecho.verticeBase;
+    theobject.rendering_mode = GL_TRIANGLES;
+    theobject.vertex_array_object_id = g_StaticGeometry.vao;
+    theobject.bbox_min = glm::vec3(-0.4f, -0.6f, 0.0f);
+    theobject.bbox_max = glm::vec3( 0.4f,  0.6f, 0.0f);
+    TNivelLod lod = { (unsigned int) trecho.primeiroIndice, (unsigned int) trecho.numIndices, 0.0f };
+    theobject.lods.push_back(lod);
+    AddVirtualObject(theobject, "label");
+}
+
+// Gera o atlas de glifos (glyph_atlas.h) e o envia para a unidade UNIDADE_GLIFOS.
+void LoadGlyphAtlas()
+{
+    std::vector<unsigned char> pixels;
+    GeraAtlasGlifos(pixels);
+
+    GLuint texture_id;
+    glGenTextures(1, &texture_id);
+    glActiveTexture(GL_TEXTURE0 + UNIDADE_GLIFOS);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, ATLAS_GLIFOS * ATLAS_GLIFO_LARGURA, ATLAS_GLIFO_ALTURA,
+                 0, GL_RED, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+// Nível de detalhe de um objeto desenhado com centro "center" (no mundo) e
+// escala "scale": o mais simples cujo erro, projetado na tela, não passa de
+// LOD_PIXEL_ERROR pixels.
+int SelectLod(int handle, const glm::vec4& center, float scale)
+{
+    const SceneObject& object = g_SceneObjects[handle];
+
+    float pixels_per_unit = g_LodPixelsPerUnit * scale;
+    if (g_LodPerspective)
+        pixels_per_unit /= std::max(norm(center - g_LodCameraPosition), 0.1f);
+
+    int lod = 0;
+    while (lod + 1 < (int) object.lods.size() && object.lods[lod + 1].erro * pixels_per_unit <= LOD_PIXEL_ERROR)
+        lod++;
+    return lod;
+}
+
+// Item da fila de desenho com a geometria, o VAO e a AABB de um objeto da
+// cena. Com lod < 0, o nível de detalhe sai do centro da AABB e da maior
+// escala de "modelo".
+TItemDesenho ItemObjeto(int handle, GLint objeto, const glm::mat4& modelo, int lod)
+{
+    const SceneObject& object = g_SceneObjects[handle];
+
+    if (lod < 0)
+    {
+        glm::vec4 center = modelo * glm::vec4((object.bbox_min + object.bbox_max) / 2.0f, 1.0f);
+        float scale = std::max(std::max(norm(modelo[0]), norm(modelo[1])), norm(modelo[2]));
+        lod = SelectLod(handle, center, scale);
+    }
+    size_t first_index = object.first_index, num_indices = object.num_indices;
+    if (lod < (int) object.lods.size())
+    {
+        first_index = object.lods[lod].primeiroIndice;
+        num_indices = object.lods[lod].numIndices;
+    }
+
+    TItemDesenho item = ItemDesenho(program_id, object.vertex_array_object_id, objeto,
+                                    object.rendering_mode, num_indices, first_index, modelo);
+    item.verticeBase = object.base_vertex;
+    item.bboxMin = object.bbox_min;
+    item.bboxMax = object.bbox_max;
+    return item;
 }
 
 // Função que pega a matriz M e guarda a mesma no topo da pilha
@@ -1102,14 +1528,15 @@ void DrawCube(GLint render_as_black_uniform)
     // "model", "view" e "projection" definidas acima e já enviadas
     // para a placa de vídeo (GPU).
     //
-    // Veja a definição de g_VirtualScene["cube_faces"] dentro da
+    // Veja o registro do objeto "cube_faces" dentro da
     // função BuildTriangles(), e veja a documentação da função
     // glDrawElements() em http://docs.gl/gl3/glDrawElements.
+    static int cube_faces = FindVirtualObject("cube_faces");
     glDrawElements(
-        g_VirtualScene["cube_faces"].rendering_mode, // Veja slides 182-188 do documento Aula_04_Modelagem_Geometrica_3D.pdf
-        g_VirtualScene["cube_faces"].num_indices,    //
+        g_SceneObjects[cube_faces].rendering_mode, // Veja slides 182-188 do documento Aula_04_Modelagem_Geometrica_3D.pdf
+        g_SceneObjects[cube_faces].num_indices,    //
         GL_UNSIGNED_INT,
-        (void*)g_VirtualScene["cube_faces"].first_index
+        (void*)g_SceneObjects[cube_faces].first_index
     );
 
     // Pedimos para OpenGL desenhar linhas com largura de 4 pixels.
@@ -1117,7 +1544,7 @@ void DrawCube(GLint render_as_black_uniform)
 
     // Pedimos para a GPU rasterizar os vértices dos eixos XYZ
     // apontados pelo VAO como linhas. Veja a definição de
-    // g_VirtualScene["axes"] dentro da função BuildTriangles(), e veja
+    // "axes" dentro da função BuildTriangles(), e veja
     // a documentação da função glDrawElements() em
     // http://docs.gl/gl3/glDrawElements.
     //
@@ -1126,10 +1553,10 @@ void DrawCube(GLint render_as_black_uniform)
     // geométricas que o cubo. Isto é, estes eixos estarão
     // representando o sistema de coordenadas do modelo (e não o global)!
     // glDrawElements(
-    //     g_VirtualScene["axes"].rendering_mode,
-    //     g_VirtualScene["axes"].num_indices,
+    //     g_SceneObjects[axes].rendering_mode,
+    //     g_SceneObjects[axes].num_indices,
     //     GL_UNSIGNED_INT,
-    //     (void*)g_VirtualScene["axes"].first_index
+    //     (void*)g_SceneObjects[axes].first_index
     // );
 
     // Informamos para a placa de vídeo (GPU) que a variável booleana
@@ -1139,14 +1566,14 @@ void DrawCube(GLint render_as_black_uniform)
 
     // Pedimos para a GPU rasterizar os vértices do cubo apontados pelo
     // VAO como linhas, formando as arestas pretas do cubo. Veja a
-    // definição de g_VirtualScene["cube_edges"] dentro da função
+    // definição de "cube_edges" dentro da função
     // BuildTriangles(), e veja a documentação da função
     // glDrawElements() em http://docs.gl/gl3/glDrawElements.
     // glDrawElements(
-    //     g_VirtualScene["cube_edges"].rendering_mode,
-    //     g_VirtualScene["cube_edges"].num_indices,
+    //     g_SceneObjects[cube_edges].rendering_mode,
+    //     g_SceneObjects[cube_edges].num_indices,
     //     GL_UNSIGNED_INT,
-    //     (void*)g_VirtualScene["cube_edges"].first_index
+    //     (void*)g_SceneObjects[cube_edges].first_index
     // );
 }
 
@@ -1333,8 +1760,8 @@ GLuint BuildTriangles()
     cube_faces.num_indices    = 36;       // Último índice está em indices[35]; total de 36 índices.
     cube_faces.rendering_mode = GL_TRIANGLES; // Índices correspondem ao tipo de rasterização GL_TRIANGLES.
 
-    // Adicionamos o objeto criado acima na nossa cena virtual (g_VirtualScene).
-    g_VirtualScene["cube_faces"] = cube_faces;
+    // Adicionamos o objeto criado acima na nossa cena virtual (g_SceneObjects).
+    AddVirtualObject(cube_faces, "cube_faces");
 
     // Criamos um segundo objeto virtual (SceneObject) que se refere às arestas
     // pretas do cubo.
@@ -1344,8 +1771,8 @@ GLuint BuildTriangles()
     cube_edges.num_indices    = 24; // Último índice está em indices[59]; total de 24 índices.
     cube_edges.rendering_mode = GL_LINES; // Índices correspondem ao tipo de rasterização GL_LINES.
 
-    // Adicionamos o objeto criado acima na nossa cena virtual (g_VirtualScene).
-    g_VirtualScene["cube_edges"] = cube_edges;
+    // Adicionamos o objeto criado acima na nossa cena virtual (g_SceneObjects).
+    AddVirtualObject(cube_edges, "cube_edges");
 
     // Criamos um terceiro objeto virtual (SceneObject) que se refere aos eixos XYZ.
     SceneObject axes;
@@ -1353,7 +1780,7 @@ GLuint BuildTriangles()
     axes.first_index    = (size_t)(60*sizeof(GLuint)); // Primeiro índice está em indices[60]
     axes.num_indices    = 6; // Último índice está em indices[65]; total de 6 índices.
     axes.rendering_mode = GL_LINES; // Índices correspondem ao tipo de rasterização GL_LINES.
-    g_VirtualScene["axes"] = axes;
+    AddVirtualObject(axes, "axes");
 
     // Criamos um buffer OpenGL para armazenar os índices acima
     GLuint indices_id;
@@ -1548,6 +1975,7 @@ void FramebufferSizeCallback(GLFWwindow* window, int width, int height)
     // O cast para float é necessário pois números inteiros são arredondados ao
     // serem divididos!
     g_ScreenRatio = (float)width / height;
+    g_ScreenHeight = (float)height;
 }
 
 // Variáveis globais que armazenam a última posição do cursor do mouse, para
@@ -1794,7 +2222,65 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     {
         g_UsePerspectiveProjection = false;
     }
-    if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9 && action == GLFW_PRESS){
+
+    // Se o usuário apertar a tecla B, alternamos o balanceamento da árvore: ABP -> AVL -> rubro-negra.
+    if (key == GLFW_KEY_B && action == GLFW_PRESS)
+    {
+        const char* modos[3] = {"ABP", "AVL", "rubro-negra"};
+        DefineModoArvore((ModoArvore() + 1) % 3);
+        sincronizaAnimacao();
+        tree = ReconstroiArvore(tree);
+        printf("Balanceamento: %s\n", modos[ModoArvore()]);
+    }
+
+    // Se o usuário apertar a tecla T, alternamos o layout: níveis divididos ao meio ou Reingold-Tilford.
+    if (key == GLFW_KEY_T && action == GLFW_PRESS)
+    {
+        layoutArrumado = !layoutArrumado;
+        printf("Layout: %s\n", layoutArrumado ? "Reingold-Tilford" : "por nivel");
+    }
+
+    // Se o usuário apertar a tecla G, a animação dos nodos passa a ser feita no vertex shader (ou volta para a CPU).
+    if (key == GLFW_KEY_G && action == GLFW_PRESS)
+    {
+        sincronizaAnimacao();
+        animacaoGPU = !animacaoGPU;
+        printf("Animacao: %s\n", animacaoGPU ? "GPU" : "CPU");
+    }
+
+    // Se o usuário apertar a tecla C, apagamos a árvore inteira de uma só vez.
+    if (key == GLFW_KEY_C && action == GLFW_PRESS)
+    {
+        TEstatisticasPool e = EstatisticasPool(PoolArvore());
+        printf("Apagando arvore: %zu nodos vivos, %zu reservados\n", e.vivos, e.reservados);
+        EsvaziaPool(PoolArvore());
+        tree = NULL;
+        DestroiHistorico(&historico);
+    }
+
+    // Se o usuário apertar U (ou R), voltamos à versão anterior (ou seguinte) da árvore.
+    if ((key == GLFW_KEY_U || key == GLFW_KEY_R) && action == GLFW_PRESS)
+    {
+        if (key == GLFW_KEY_U ? Desfaz(&historico) : Refaz(&historico))
+            mostraVersao();
+    }
+    // Se o usuário apertar a tecla F, mostramos quantas mudanças de estado a
+    // fila de desenho mandou para a GPU e quantas evitou no último quadro.
+    if (key == GLFW_KEY_F && action == GLFW_PRESS)
+    {
+        TEstatisticasFila e = g_FilaDesenho.estatisticas;
+        printf("Fila de desenho: %d itens em %d desenhos, %d mudancas de estado emitidas, %d puladas\n",
+               e.itens, e.desenhos, e.emitidas, e.puladas);
+        for (int g = 0; g < NUM_GRUPOS; g++)
+        {
+            printf("  %s por nivel de detalhe:", instancias[g].objeto);
+            for (int l = 0; l < instancias[g].niveis; l++)
+                printf(" %zu", instancias[g].porNivel[l].size());
+            printf("\n");
+        }
+    }
+    // Até 9 dígitos, para caber num int.
+    if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9 && action == GLFW_PRESS && inputText.size() < 9){
         switch(key){
             case GLFW_KEY_0:
                 inputText += '0';
@@ -1832,9 +2318,9 @@ void KeyCallback(GLFWwindow* window, int key, int scancode, int action, int mod)
     if (key == GLFW_KEY_ENTER){
         if (inputText !=  ""){
             int b = atoi(inputText.c_str());
-            if(b <100){
-                tree = InsereArvore(tree, b);
-            }
+            sincronizaAnimacao();
+            tree = InsereArvore(tree, b);
+            HistoricoInsere(&historico, b);
             inputText = "";
         }
     }
@@ -1848,24 +2334,50 @@ void ErrorCallback(int error, const char* description)
 
 
 // Função que carrega uma imagem para ser utilizada como textura
-void LoadTextureImage(const char* filename)
+// Uma imagem sendo carregada pelo g_Loader (LoadTextureImageAsync()).
+struct TextureLoad
 {
-    printf("Carregando imagem \"%s\"... ", filename);
+    std::string    filename;
+    GLuint         textureunit;
+    unsigned char* data;
+    int            width;
+    int            height;
+};
 
-    // Primeiro fazemos a leitura da imagem do disco
-    stbi_set_flip_vertically_on_load(true);
-    int width;
-    int height;
+// Leitura e decodificação da imagem, numa thread do carregador.
+// stbi_set_flip_vertically_on_load() é chamada antes, na thread principal.
+void DecodeTextureImage(TextureLoad* load)
+{
+    const char* filename = load->filename.c_str();
     int channels;
-    unsigned char *data = stbi_load(filename, &width, &height, &channels, 3);
+    load->data = stbi_load(filename, &load->width, &load->height, &channels, 3);
 
-    if ( data == NULL )
+    if ( load->data == NULL )
     {
         fprintf(stderr, "ERROR: Cannot open image file \"%s\".\n", filename);
         std::exit(EXIT_FAILURE);
     }
 
-    printf("OK (%dx%d).\n", width, height);
+    printf("Imagem \"%s\" decodificada (%dx%d).\n", filename, load->width, load->height);
+}
+
+void LoadTextureImageAsync(TCarregador* loader, const char* filename, GLuint textureunit)
+{
+    std::shared_ptr<TextureLoad> load(new TextureLoad());
+    load->filename = filename;
+    load->textureunit = textureunit;
+    load->data = NULL;
+    AgendaCarga(loader, filename,
+                [load]() { DecodeTextureImage(load.get()); },
+                [load]() { UploadTextureImage(load.get()); });
+}
+
+// Envia uma imagem já decodificada para a GPU, na unidade pedida.
+void UploadTextureImage(TextureLoad* load)
+{
+    unsigned char* data = load->data;
+    int width = load->width;
+    int height = load->height;
 
     // Agora criamos objetos na GPU com OpenGL para armazenar a textura
     GLuint texture_id;
@@ -1887,7 +2399,7 @@ void LoadTextureImage(const char* filename)
     glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
     glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 
-    GLuint textureunit = g_NumLoadedTextures;
+    GLuint textureunit = load->textureunit;
     glActiveTexture(GL_TEXTURE0 + textureunit);
     glBindTexture(GL_TEXTURE_2D, texture_id);
     glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
@@ -1895,6 +2407,7 @@ void LoadTextureImage(const char* filename)
     glBindSampler(textureunit, sampler_id);
 
     stbi_image_free(data);
+    load->data = NULL;
 
     g_NumLoadedTextures += 1;
 }
@@ -1942,11 +2455,23 @@ void LoadShadersFromFiles()
     object_id_uniform       = glGetUniformLocation(program_id, "object_id"); // Variável "object_id" em shader_fragment.glsl
     bbox_min_uniform        = glGetUniformLocation(program_id, "bbox_min");
     bbox_max_uniform        = glGetUniformLocation(program_id, "bbox_max");
+    nodos_instanciados_uniform = glGetUniformLocation(program_id, "nodos_instanciados"); // Nodos da árvore, em shader_vertex.glsl
+    anim_progresso_uniform  = glGetUniformLocation(program_id, "anim_progresso");
+    raio_nodo_uniform       = glGetUniformLocation(program_id, "raio_nodo");
+
+    g_FilaDesenho.uniformModelo      = model_uniform;
+    g_FilaDesenho.uniformObjeto      = object_id_uniform;
+    g_FilaDesenho.uniformInstanciado = nodos_instanciados_uniform;
+    g_FilaDesenho.uniformBboxMin     = bbox_min_uniform;
+    g_FilaDesenho.uniformBboxMax     = bbox_max_uniform;
 
     // Variáveis em "shader_fragment.glsl" para acesso das imagens de textura
     glUseProgram(program_id);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage0"), 0);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage1"), 1);
     glUniform1i(glGetUniformLocation(program_id, "TextureImage2"), 2);
+    glUniform1i(glGetUniformLocation(program_id, "animacao"), UNIDADE_ANIMACAO);
+    glUniform1i(glGetUniformLocation(program_id, "AtlasGlifos"), UNIDADE_GLIFOS);
+    glUniform2f(glGetUniformLocation(program_id, "tela"), WINDOW_WIDTH, WINDOW_HEIGHT);
     glUseProgram(0);
 }
\ No newline at end of file
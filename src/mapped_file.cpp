@@ -0,0 +1,99 @@
+#include <mapped_file.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+bool MapeiaArquivo(const char* caminho, TArquivoMapeado* arquivo)
+{
+    arquivo->dados = NULL;
+    arquivo->tamanho = 0;
+    arquivo->mapeado = false;
+
+#ifndef _WIN32
+    int fd = open(caminho, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return false;
+    }
+    arquivo->tamanho = (size_t) st.st_size;
+    if (arquivo->tamanho == 0)
+    {
+        // mmap de tamanho zero falha; um arquivo vazio ainda e' valido.
+        close(fd);
+        arquivo->dados = "";
+        return true;
+    }
+    void* p = mmap(NULL, arquivo->tamanho, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    arquivo->dados = (const char*) p;
+    arquivo->mapeado = true;
+    return true;
+#else
+    FILE* f = fopen(caminho, "rb");
+    if (!f)
+        return false;
+    fseek(f, 0, SEEK_END);
+    long tamanho = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    if (tamanho < 0)
+    {
+        fclose(f);
+        return false;
+    }
+    char* buffer = (char*) malloc(tamanho > 0 ? tamanho : 1);
+    if (!buffer || fread(buffer, 1, tamanho, f) != (size_t) tamanho)
+    {
+        free(buffer);
+        fclose(f);
+        return false;
+    }
+    fclose(f);
+    arquivo->dados = buffer;
+    arquivo->tamanho = (size_t) tamanho;
+    return true;
+#endif
+}
+
+void DesmapeiaArquivo(TArquivoMapeado* arquivo)
+{
+#ifndef _WIN32
+    if (arquivo->mapeado)
+        munmap((void*) arquivo->dados, arquivo->tamanho);
+#else
+    free((void*) arquivo->dados);
+#endif
+    arquivo->dados = NULL;
+    arquivo->tamanho = 0;
+    arquivo->mapeado = false;
+}
+
+unsigned long long HashDados(const char* dados, size_t tamanho)
+{
+    const unsigned long long primo = 1099511628211ull;
+    unsigned long long h = 14695981039346656037ull;
+    size_t i = 0;
+    for (; i + 8 <= tamanho; i += 8)
+    {
+        unsigned long long palavra;
+        memcpy(&palavra, dados + i, 8);
+        h = (h ^ palavra) * primo;
+        h ^= h >> 29;
+    }
+    for (; i < tamanho; i++)
+        h = (h ^ (unsigned char) dados[i]) * primo;
+    return h ^ tamanho;
+}
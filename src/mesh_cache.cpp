@@ -0,0 +1,163 @@
+#include <mesh_cache.h>
+
+#include <cstdio>
+#include <cstring>
+
+static const char MAGICO_CACHE[4] = { 'T', 'V', 'M', 'C' };
+
+// Leitura sequencial com verificacao de limites; "ok" cai para falso no
+// primeiro acesso fora do arquivo e as leituras seguintes nao fazem nada.
+struct TLeitor
+{
+    const char* p;
+    const char* fim;
+    bool ok;
+};
+
+static const char* pega(TLeitor* l, size_t bytes)
+{
+    bytes = (bytes + 3) & ~(size_t) 3;
+    if (!l->ok || (size_t)(l->fim - l->p) < bytes)
+    {
+        l->ok = false;
+        return NULL;
+    }
+    const char* r = l->p;
+    l->p += bytes;
+    return r;
+}
+
+static unsigned int pegaInteiro(TLeitor* l)
+{
+    unsigned int v = 0;
+    const char* p = pega(l, 4);
+    if (p)
+        memcpy(&v, p, 4);
+    return v;
+}
+
+bool AbreCacheMalhas(const char* caminho, unsigned long long hashFonte, TCacheMalhas* cache)
+{
+    cache->objetos.clear();
+    if (!MapeiaArquivo(caminho, &cache->arquivo))
+        return false;
+
+    TLeitor l = { cache->arquivo.dados, cache->arquivo.dados + cache->arquivo.tamanho, true };
+    const char* magico = pega(&l, 4);
+    unsigned int versao = pegaInteiro(&l);
+    unsigned long long hash = 0;
+    const char* h = pega(&l, 8);
+    if (h)
+        memcpy(&hash, h, 8);
+    unsigned int numObjetos = pegaInteiro(&l);
+
+    if (!l.ok || memcmp(magico, MAGICO_CACHE, 4) != 0 || versao != VERSAO_CACHE_MALHAS || hash != hashFonte)
+    {
+        FechaCacheMalhas(cache);
+        return false;
+    }
+
+    for (unsigned int i = 0; i < numObjetos && l.ok; i++)
+    {
+        TVistaCozida v;
+        v.tamanhoNome = pegaInteiro(&l);
+        v.nome = pega(&l, v.tamanhoNome);
+        const float* bbox = (const float*) pega(&l, 6*sizeof(float));
+        if (bbox)
+        {
+            memcpy(v.bboxMin, bbox, 3*sizeof(float));
+            memcpy(v.bboxMax, bbox + 3, 3*sizeof(float));
+        }
+        v.numVertices = pegaInteiro(&l);
+        v.numIndices = pegaInteiro(&l);
+        unsigned int atributos = pegaInteiro(&l);
+        v.numNiveis = pegaInteiro(&l);
+        v.niveis = (const TNivelLod*) pega(&l, sizeof(TNivelLod)*(size_t) v.numNiveis);
+        v.posicoes = (const float*) pega(&l, 4*sizeof(float)*(size_t) v.numVertices);
+        v.normais = (atributos & COZIDO_NORMAIS) ? (const float*) pega(&l, 4*sizeof(float)*(size_t) v.numVertices) : NULL;
+        v.texcoords = (atributos & COZIDO_TEXCOORDS) ? (const float*) pega(&l, 2*sizeof(float)*(size_t) v.numVertices) : NULL;
+        v.indices = (const unsigned int*) pega(&l, sizeof(unsigned int)*(size_t) v.numIndices);
+        for (unsigned int k = 0; k < v.numNiveis && l.ok; k++)
+            if (v.niveis[k].primeiroIndice > v.numIndices || v.niveis[k].numIndices > v.numIndices - v.niveis[k].primeiroIndice)
+                l.ok = false;
+        // um indice fora dos vertices leria memoria alheia na GPU
+        for (unsigned int k = 0; k < v.numIndices && l.ok; k++)
+            if (v.indices[k] >= v.numVertices)
+                l.ok = false;
+        cache->objetos.push_back(v);
+    }
+
+    if (!l.ok)
+    {
+        fprintf(stderr, "Cache de malhas \"%s\" truncada ou invalida; sera refeita.\n", caminho);
+        FechaCacheMalhas(cache);
+        return false;
+    }
+    return true;
+}
+
+void FechaCacheMalhas(TCacheMalhas* cache)
+{
+    DesmapeiaArquivo(&cache->arquivo);
+    cache->objetos.clear();
+}
+
+static void escreve(FILE* f, const void* dados, size_t bytes)
+{
+    static const char zeros[4] = { 0, 0, 0, 0 };
+    if (bytes == 0)
+        return;
+    fwrite(dados, 1, bytes, f);
+    fwrite(zeros, 1, ((bytes + 3) & ~(size_t) 3) - bytes, f);
+}
+
+static void escreveInteiro(FILE* f, unsigned int v)
+{
+    fwrite(&v, 4, 1, f);
+}
+
+bool GravaCacheMalhas(const char* caminho, unsigned long long hashFonte,
+                      const std::vector<TObjetoCozido>& objetos)
+{
+    // Grava num temporario e renomeia: quem abrir a cache no meio da escrita
+    // (ou depois de uma escrita interrompida) nao ve um arquivo pela metade.
+    std::string temporario = std::string(caminho) + ".tmp";
+    FILE* f = fopen(temporario.c_str(), "wb");
+    if (!f)
+        return false;
+
+    fwrite(MAGICO_CACHE, 1, 4, f);
+    escreveInteiro(f, VERSAO_CACHE_MALHAS);
+    fwrite(&hashFonte, 8, 1, f);
+    escreveInteiro(f, (unsigned int) objetos.size());
+
+    for (size_t i = 0; i < objetos.size(); i++)
+    {
+        const TObjetoCozido& o = objetos[i];
+        const TMalha& m = o.malha;
+        escreveInteiro(f, (unsigned int) o.nome.size());
+        escreve(f, o.nome.data(), o.nome.size());
+        fwrite(o.bboxMin, sizeof(float), 3, f);
+        fwrite(o.bboxMax, sizeof(float), 3, f);
+        escreveInteiro(f, (unsigned int) NumVerticesMalha(m));
+        escreveInteiro(f, (unsigned int) m.indices.size());
+        escreveInteiro(f, (m.normais.empty() ? 0 : COZIDO_NORMAIS) | (m.texcoords.empty() ? 0 : COZIDO_TEXCOORDS));
+        escreveInteiro(f, (unsigned int) o.niveis.size());
+        escreve(f, o.niveis.data(), o.niveis.size() * sizeof(TNivelLod));
+        escreve(f, m.posicoes.data(), m.posicoes.size() * sizeof(float));
+        escreve(f, m.normais.data(), m.normais.size() * sizeof(float));
+        escreve(f, m.texcoords.data(), m.texcoords.size() * sizeof(float));
+        escreve(f, m.indices.data(), m.indices.size() * sizeof(unsigned int));
+    }
+
+    bool ok = !ferror(f);
+    ok = (fclose(f) == 0) && ok;
+    if (ok)
+    {
+        remove(caminho); // rename nao substitui um arquivo existente no Windows
+        ok = rename(temporario.c_str(), caminho) == 0;
+    }
+    if (!ok)
+        remove(temporario.c_str());
+    return ok;
+}
@@ -0,0 +1,223 @@
+#include <mesh_optimizer.h>
+
+#include <cstring>
+#include <unordered_map>
+
+// Posicao, normal e coordenada de textura de um vertice, comparadas bit a bit.
+struct TChaveVertice
+{
+    float a[10];
+    bool operator==(const TChaveVertice& o) const { return memcmp(a, o.a, sizeof(a)) == 0; }
+};
+
+struct THashVertice
+{
+    size_t operator()(const TChaveVertice& c) const
+    {
+        // FNV-1a sobre os bytes
+        const unsigned char* p = (const unsigned char*) c.a;
+        size_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(c.a); i++)
+            h = (h ^ p[i]) * 16777619u;
+        return h;
+    }
+};
+
+// Copia os atributos do vertice antigo v para a posicao novo[v].
+static void remapeiaVertices(TMalha* m, const std::vector<unsigned int>& novo, size_t numNovos)
+{
+    size_t n = NumVerticesMalha(*m);
+    std::vector<float> posicoes(4*numNovos), normais(m->normais.empty() ? 0 : 4*numNovos),
+                       texcoords(m->texcoords.empty() ? 0 : 2*numNovos);
+    for (size_t v = 0; v < n; v++)
+    {
+        unsigned int d = novo[v];
+        memcpy(&posicoes[4*d], &m->posicoes[4*v], 4*sizeof(float));
+        if (!normais.empty())
+            memcpy(&normais[4*d], &m->normais[4*v], 4*sizeof(float));
+        if (!texcoords.empty())
+            memcpy(&texcoords[2*d], &m->texcoords[2*v], 2*sizeof(float));
+    }
+    m->posicoes.swap(posicoes);
+    m->normais.swap(normais);
+    m->texcoords.swap(texcoords);
+    for (size_t i = 0; i < m->indices.size(); i++)
+        m->indices[i] = novo[m->indices[i]];
+}
+
+size_t SoldaVertices(TMalha* m)
+{
+    size_t n = NumVerticesMalha(*m);
+    std::unordered_map<TChaveVertice, unsigned int, THashVertice> vistos;
+    vistos.reserve(n);
+
+    std::vector<unsigned int> novo(n);
+    unsigned int numNovos = 0;
+    for (size_t v = 0; v < n; v++)
+    {
+        TChaveVertice c;
+        memset(c.a, 0, sizeof(c.a));
+        memcpy(&c.a[0], &m->posicoes[4*v], 4*sizeof(float));
+        if (!m->normais.empty())
+            memcpy(&c.a[4], &m->normais[4*v], 4*sizeof(float));
+        if (!m->texcoords.empty())
+            memcpy(&c.a[8], &m->texcoords[2*v], 2*sizeof(float));
+
+        std::pair<std::unordered_map<TChaveVertice, unsigned int, THashVertice>::iterator, bool> r =
+            vistos.insert(std::make_pair(c, numNovos));
+        novo[v] = r.first->second;
+        if (r.second)
+            numNovos++;
+    }
+
+    // Vertices repetidos escrevem o mesmo destino com os mesmos valores.
+    remapeiaVertices(m, novo, numNovos);
+    return numNovos;
+}
+
+// Proximo vertice em volta do qual emitir triangulos: entre os candidatos
+// (vertices do ultimo leque), o que ainda tem triangulos e continuaria na
+// cache depois de emiti-los, preferindo o mais antigo. Sem nenhum, volta
+// pela pilha de becos sem saida e, por fim, varre os vertices em ordem.
+static int proximoVertice(const std::vector<int>& candidatos, const std::vector<int>& vivos,
+                          const std::vector<int>& tempoCache, int s, int k,
+                          std::vector<int>& becos, size_t& cursor)
+{
+    int melhor = -1, prioridadeMelhor = -1;
+    for (size_t i = 0; i < candidatos.size(); i++)
+    {
+        int v = candidatos[i];
+        if (vivos[v] <= 0)
+            continue;
+        int p = 0;
+        if (s - tempoCache[v] + 2*vivos[v] <= k)
+            p = s - tempoCache[v];
+        if (p > prioridadeMelhor)
+        {
+            prioridadeMelhor = p;
+            melhor = v;
+        }
+    }
+    if (melhor != -1)
+        return melhor;
+
+    while (!becos.empty())
+    {
+        int v = becos.back();
+        becos.pop_back();
+        if (vivos[v] > 0)
+            return v;
+    }
+    for (; cursor < vivos.size(); cursor++)
+        if (vivos[cursor] > 0)
+            return (int) cursor++;
+    return -1;
+}
+
+void OtimizaCacheVertices(TMalha* m, int tamanhoCache)
+{
+    size_t n = NumVerticesMalha(*m);
+    size_t numTriangulos = m->indices.size() / 3;
+    if (numTriangulos == 0)
+        return;
+
+    // Triangulos de cada vertice, em formato compacto (inicio[v]..inicio[v+1]).
+    std::vector<int> vivos(n, 0);
+    for (size_t i = 0; i < 3*numTriangulos; i++)
+        vivos[m->indices[i]]++;
+    std::vector<int> inicio(n + 1, 0);
+    for (size_t v = 0; v < n; v++)
+        inicio[v + 1] = inicio[v] + vivos[v];
+    std::vector<int> adjacentes(inicio[n]);
+    std::vector<int> preenchido(inicio.begin(), inicio.end() - 1);
+    for (size_t t = 0; t < numTriangulos; t++)
+        for (int j = 0; j < 3; j++)
+            adjacentes[preenchido[m->indices[3*t + j]]++] = (int) t;
+
+    std::vector<int> tempoCache(n, 0);
+    std::vector<bool> emitido(numTriangulos, false);
+    std::vector<int> becos, candidatos;
+    std::vector<unsigned int> saida;
+    saida.reserve(3*numTriangulos);
+
+    int k = tamanhoCache;
+    int s = k + 1;
+    size_t cursor = 1;
+    int f = 0;
+    while (f >= 0)
+    {
+        candidatos.clear();
+        for (int a = inicio[f]; a < inicio[f + 1]; a++)
+        {
+            int t = adjacentes[a];
+            if (emitido[t])
+                continue;
+            for (int j = 0; j < 3; j++)
+            {
+                int v = m->indices[3*t + j];
+                saida.push_back(v);
+                becos.push_back(v);
+                candidatos.push_back(v);
+                vivos[v]--;
+                if (s - tempoCache[v] > k)
+                {
+                    tempoCache[v] = s;
+                    s++;
+                }
+            }
+            emitido[t] = true;
+        }
+        f = proximoVertice(candidatos, vivos, tempoCache, s, k, becos, cursor);
+    }
+
+    m->indices.swap(saida);
+}
+
+void OtimizaBuscaVertices(TMalha* m)
+{
+    size_t n = NumVerticesMalha(*m);
+    const unsigned int nenhum = ~0u;
+    std::vector<unsigned int> novo(n, nenhum);
+    unsigned int proximo = 0;
+    for (size_t i = 0; i < m->indices.size(); i++)
+        if (novo[m->indices[i]] == nenhum)
+            novo[m->indices[i]] = proximo++;
+    // Vertices que nenhum triangulo usa vao para o fim.
+    for (size_t v = 0; v < n; v++)
+        if (novo[v] == nenhum)
+            novo[v] = proximo++;
+    remapeiaVertices(m, novo, n);
+}
+
+double CalculaACMR(const std::vector<unsigned int>& indices, size_t numVertices, int tamanhoCache)
+{
+    size_t numTriangulos = indices.size() / 3;
+    if (numTriangulos == 0)
+        return 0.0;
+
+    // FIFO: o vertice esta na cache se entrou ha menos de "tamanhoCache" faltas.
+    std::vector<size_t> entrada(numVertices, 0);
+    size_t faltas = 0;
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        unsigned int v = indices[i];
+        if (entrada[v] == 0 || faltas + 1 - entrada[v] > (size_t) tamanhoCache)
+        {
+            faltas++;
+            entrada[v] = faltas;
+        }
+    }
+    return (double) faltas / numTriangulos;
+}
+
+TRelatorioMalha OtimizaMalha(TMalha* m)
+{
+    TRelatorioMalha r;
+    r.verticesAntes = NumVerticesMalha(*m);
+    r.verticesDepois = SoldaVertices(m);
+    r.acmrSoldada = CalculaACMR(m->indices, r.verticesDepois, TAMANHO_CACHE_VERTICES);
+    OtimizaCacheVertices(m, TAMANHO_CACHE_VERTICES);
+    OtimizaBuscaVertices(m);
+    r.acmrOtimizada = CalculaACMR(m->indices, r.verticesDepois, TAMANHO_CACHE_VERTICES);
+    return r;
+}
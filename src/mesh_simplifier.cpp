@@ -0,0 +1,325 @@
+#include <mesh_simplifier.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+// Soma de (n.p + d)^2 sobre os planos dos triangulos em volta de um vertice,
+// cada plano pesando a area do triangulo. "peso" e' a soma das areas: o
+// custo de um colapso e' a media ponderada, e a raiz dele uma distancia.
+struct TQuadrica
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    double peso;
+};
+
+static void somaQuadrica(TQuadrica* q, const TQuadrica& r)
+{
+    q->a2 += r.a2; q->ab += r.ab; q->ac += r.ac; q->ad += r.ad;
+    q->b2 += r.b2; q->bc += r.bc; q->bd += r.bd;
+    q->c2 += r.c2; q->cd += r.cd; q->d2 += r.d2;
+    q->peso += r.peso;
+}
+
+static double avaliaQuadrica(const TQuadrica& q, const float* p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double e = q.a2*x*x + q.b2*y*y + q.c2*z*z + q.d2
+             + 2.0*(q.ab*x*y + q.ac*x*z + q.bc*y*z + q.ad*x + q.bd*y + q.cd*z);
+    return e > 0.0 ? e : 0.0;
+}
+
+static void normalTriangulo(const float* a, const float* b, const float* c, double n[3])
+{
+    double ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+    double wx = c[0] - a[0], wy = c[1] - a[1], wz = c[2] - a[2];
+    n[0] = uy*wz - uz*wy;
+    n[1] = uz*wx - ux*wz;
+    n[2] = ux*wy - uy*wx;
+}
+
+// Posicao de um vertice, comparada bit a bit.
+struct TChavePosicao
+{
+    float p[3];
+    bool operator==(const TChavePosicao& o) const { return memcmp(p, o.p, sizeof(p)) == 0; }
+};
+
+struct THashPosicao
+{
+    size_t operator()(const TChavePosicao& c) const
+    {
+        // FNV-1a sobre os bytes
+        const unsigned char* p = (const unsigned char*) c.p;
+        size_t h = 2166136261u;
+        for (size_t i = 0; i < sizeof(c.p); i++)
+            h = (h ^ p[i]) * 16777619u;
+        return h;
+    }
+};
+
+struct TColapso
+{
+    double       custo;
+    unsigned int de, para;
+    bool operator<(const TColapso& o) const { return custo < o.custo; }
+};
+
+float SimplificaMalha(const TMalha& m, const std::vector<unsigned int>& indices,
+                      size_t numIndicesAlvo, std::vector<unsigned int>* saida)
+{
+    const float* pos = m.posicoes.data();
+    size_t n = NumVerticesMalha(m);
+
+    // A topologia e' sobre posicoes: vertices que so' diferem na normal ou
+    // na textura (costuras) viram um so', "local[v]", o primeiro deles.
+    std::vector<unsigned int> local(n);
+    std::vector<int> copias(n, 0);
+    {
+        std::unordered_map<TChavePosicao, unsigned int, THashPosicao> vistos;
+        vistos.reserve(n);
+        for (size_t v = 0; v < n; v++)
+        {
+            TChavePosicao c;
+            memcpy(c.p, &pos[4*v], sizeof(c.p));
+            local[v] = vistos.insert(std::make_pair(c, (unsigned int) v)).first->second;
+            copias[local[v]]++;
+        }
+    }
+
+    std::vector<unsigned int> tri(indices);
+    size_t numTri = tri.size() / 3;
+
+    TQuadrica zero;
+    memset(&zero, 0, sizeof(zero));
+    std::vector<TQuadrica> q(n, zero);
+    for (size_t t = 0; t < numTri; t++)
+    {
+        unsigned int a = local[tri[3*t]], b = local[tri[3*t + 1]], c = local[tri[3*t + 2]];
+        double nt[3];
+        normalTriangulo(&pos[4*a], &pos[4*b], &pos[4*c], nt);
+        double tamanho = sqrt(nt[0]*nt[0] + nt[1]*nt[1] + nt[2]*nt[2]);
+        if (tamanho == 0.0)
+            continue;
+        double area = 0.5 * tamanho;
+        double x = nt[0] / tamanho, y = nt[1] / tamanho, z = nt[2] / tamanho;
+        double d = -(x*pos[4*a] + y*pos[4*a + 1] + z*pos[4*a + 2]);
+        TQuadrica p = { area*x*x, area*x*y, area*x*z, area*x*d, area*y*y, area*y*z, area*y*d,
+                        area*z*z, area*z*d, area*d*d, area };
+        somaQuadrica(&q[a], p);
+        somaQuadrica(&q[b], p);
+        somaQuadrica(&q[c], p);
+    }
+
+    // Fixos: costuras e vertices de arestas que nao tem exatamente dois
+    // triangulos (bordas e partes nao-variedade).
+    std::vector<char> fixo(n, 0);
+    for (size_t v = 0; v < n; v++)
+        if (copias[local[v]] > 1)
+            fixo[local[v]] = 1;
+    {
+        std::vector<unsigned long long> arestas;
+        arestas.reserve(3*numTri);
+        for (size_t t = 0; t < numTri; t++)
+            for (int j = 0; j < 3; j++)
+            {
+                unsigned long long a = local[tri[3*t + j]], b = local[tri[3*t + (j + 1) % 3]];
+                arestas.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+            }
+        std::sort(arestas.begin(), arestas.end());
+        for (size_t i = 0; i < arestas.size(); )
+        {
+            size_t j = i;
+            while (j < arestas.size() && arestas[j] == arestas[i])
+                j++;
+            if (j - i != 2)
+            {
+                fixo[arestas[i] >> 32] = 1;
+                fixo[arestas[i] & 0xffffffffu] = 1;
+            }
+            i = j;
+        }
+    }
+
+    // destino[u] != u: u colapsou sobre destino[u]; seus triangulos passam
+    // a usar o vertice "substituto[u]" (com a normal e textura do destino).
+    std::vector<unsigned int> destino(n), substituto(n);
+    for (size_t v = 0; v < n; v++)
+        destino[v] = substituto[v] = (unsigned int) v;
+
+    std::vector<int> inicio(n + 1), adjacentes, preenchido;
+    std::vector<TColapso> melhor(n), candidatos;
+    std::vector<char> tocado(n);
+    std::vector<unsigned int> marca(n, 0);
+    unsigned int carimbo = 0;
+    double erroMax = 0.0;
+
+    // Cada passada escolhe o colapso mais barato de cada vertice e aplica,
+    // do mais barato ao mais caro, os que nao mexem na vizinhanca uns dos
+    // outros; depois os triangulos sao refeitos.
+    while (tri.size() > numIndicesAlvo)
+    {
+        numTri = tri.size() / 3;
+
+        std::fill(inicio.begin(), inicio.end(), 0);
+        for (size_t i = 0; i < tri.size(); i++)
+            inicio[local[tri[i]] + 1]++;
+        for (size_t v = 0; v < n; v++)
+            inicio[v + 1] += inicio[v];
+        adjacentes.resize(inicio[n]);
+        preenchido.assign(inicio.begin(), inicio.end() - 1);
+        for (size_t t = 0; t < numTri; t++)
+            for (int j = 0; j < 3; j++)
+                adjacentes[preenchido[local[tri[3*t + j]]]++] = (int) t;
+
+        for (size_t v = 0; v < n; v++)
+            melhor[v].custo = HUGE_VAL;
+        for (size_t t = 0; t < numTri; t++)
+            for (int j = 0; j < 3; j++)
+            {
+                unsigned int a = local[tri[3*t + j]], b = local[tri[3*t + (j + 1) % 3]];
+                for (int sentido = 0; sentido < 2; sentido++, std::swap(a, b))
+                {
+                    if (fixo[a])
+                        continue;
+                    TQuadrica soma = q[a];
+                    somaQuadrica(&soma, q[b]);
+                    double custo = soma.peso > 0.0 ? avaliaQuadrica(soma, &pos[4*b]) / soma.peso : 0.0;
+                    if (custo < melhor[a].custo)
+                    {
+                        melhor[a].custo = custo;
+                        melhor[a].de = a;
+                        melhor[a].para = b;
+                    }
+                }
+            }
+        candidatos.clear();
+        for (size_t v = 0; v < n; v++)
+            if (melhor[v].custo != HUGE_VAL)
+                candidatos.push_back(melhor[v]);
+        std::sort(candidatos.begin(), candidatos.end());
+
+        std::fill(tocado.begin(), tocado.end(), 0);
+        size_t sobrando = numTri - numIndicesAlvo / 3, removidos = 0, feitos = 0;
+        for (size_t k = 0; k < candidatos.size() && removidos < sobrando; k++)
+        {
+            unsigned int u = candidatos[k].de, v = candidatos[k].para;
+            if (tocado[u] || tocado[v])
+                continue;
+
+            // Triangulos de u: os que tem v somem, os outros nao podem virar.
+            bool ok = true;
+            size_t comV = 0;
+            unsigned int verticeV = v;
+            carimbo += 2;
+            for (int i = inicio[u]; i < inicio[u + 1] && ok; i++)
+            {
+                const unsigned int* t = &tri[3*(size_t) adjacentes[i]];
+                unsigned int c[3] = { local[t[0]], local[t[1]], local[t[2]] };
+                for (int j = 0; j < 3; j++)
+                    marca[c[j]] = carimbo;
+                if (c[0] == v || c[1] == v || c[2] == v)
+                {
+                    comV++;
+                    for (int j = 0; j < 3; j++)
+                        if (c[j] == v)
+                            verticeV = t[j];
+                    continue;
+                }
+                double antes[3], depois[3];
+                normalTriangulo(&pos[4*c[0]], &pos[4*c[1]], &pos[4*c[2]], antes);
+                normalTriangulo(&pos[4*(c[0] == u ? v : c[0])], &pos[4*(c[1] == u ? v : c[1])],
+                                &pos[4*(c[2] == u ? v : c[2])], depois);
+                ok = antes[0]*depois[0] + antes[1]*depois[1] + antes[2]*depois[2] > 0.0;
+            }
+            if (!ok || comV == 0)
+                continue;
+
+            // Condicao de enlace: os vizinhos em comum de u e v sao so' os
+            // opostos a aresta; senao o colapso dobra a superficie.
+            size_t comuns = 0;
+            for (int i = inicio[v]; i < inicio[v + 1]; i++)
+            {
+                const unsigned int* t = &tri[3*(size_t) adjacentes[i]];
+                for (int j = 0; j < 3; j++)
+                {
+                    unsigned int w = local[t[j]];
+                    if (w != u && w != v && marca[w] == carimbo)
+                    {
+                        marca[w] = carimbo + 1;
+                        comuns++;
+                    }
+                }
+            }
+            if (comuns > comV)
+                continue;
+
+            destino[u] = v;
+            substituto[u] = verticeV;
+            somaQuadrica(&q[v], q[u]);
+            erroMax = std::max(erroMax, candidatos[k].custo);
+            removidos += comV;
+            feitos++;
+            for (int i = inicio[u]; i < inicio[u + 1]; i++)
+                for (int j = 0; j < 3; j++)
+                    tocado[local[tri[3*(size_t) adjacentes[i] + j]]] = 1;
+        }
+        if (feitos == 0)
+            break;
+
+        size_t escritos = 0;
+        for (size_t t = 0; t < numTri; t++)
+        {
+            unsigned int w[3];
+            for (int j = 0; j < 3; j++)
+            {
+                w[j] = tri[3*t + j];
+                while (destino[local[w[j]]] != local[w[j]])
+                    w[j] = substituto[local[w[j]]];
+            }
+            if (local[w[0]] == local[w[1]] || local[w[1]] == local[w[2]] || local[w[0]] == local[w[2]])
+                continue;
+            tri[escritos++] = w[0];
+            tri[escritos++] = w[1];
+            tri[escritos++] = w[2];
+        }
+        tri.resize(escritos);
+    }
+
+    saida->swap(tri);
+    return (float) sqrt(erroMax);
+}
+
+void GeraNiveisLod(TMalha* m, std::vector<TNivelLod>* niveis)
+{
+    niveis->clear();
+    std::vector<unsigned int> original(m->indices);
+    TNivelLod base = { 0, (unsigned int) original.size(), 0.0f };
+    niveis->push_back(base);
+
+    std::vector<unsigned int> nivel;
+    while (niveis->size() < MAX_NIVEIS_LOD)
+    {
+        size_t anterior = niveis->back().numIndices;
+        size_t alvo = anterior / 6 * 3;
+        if (alvo / 3 < MIN_TRIANGULOS_LOD)
+            break;
+
+        // Sempre a partir do original, para que o erro seja medido contra ele.
+        float erro = SimplificaMalha(*m, original, alvo, &nivel);
+        if (nivel.size() > anterior * 3 / 4)
+            break; // o resto esta' preso em bordas e costuras
+
+        // Reordena os triangulos do nivel para a cache; os vertices ficam
+        // onde estao, porque sao de todos os niveis.
+        m->indices.swap(nivel);
+        OtimizaCacheVertices(m, TAMANHO_CACHE_VERTICES);
+        m->indices.swap(nivel);
+
+        TNivelLod l = { (unsigned int) m->indices.size(), (unsigned int) nivel.size(),
+                        std::max(erro, niveis->back().erro) };
+        m->indices.insert(m->indices.end(), nivel.begin(), nivel.end());
+        niveis->push_back(l);
+    }
+}
@@ -0,0 +1,78 @@
+#include <cstdlib>
+#include <node_pool.h>
+
+void IniciaPool(TPoolNodos* pool)
+{
+    pool->slabs.clear();
+    pool->slabAtual = 0;
+    pool->usadosSlab = 0;
+    pool->livres = NULL;
+    pool->vivos = 0;
+}
+
+pNodoA* AlocaNodo(TPoolNodos* pool)
+{
+    pNodoA* nodo;
+
+    if (pool->livres != NULL)
+    {
+        nodo = pool->livres;
+        pool->livres = nodo->esq;
+    }
+    else
+    {
+        if (pool->usadosSlab == POOL_NODOS_POR_SLAB)
+        {
+            pool->slabAtual += 1;
+            pool->usadosSlab = 0;
+        }
+        // Depois de EsvaziaPool() os slabs antigos sao reaproveitados antes
+        // de pedirmos memoria nova.
+        if (pool->slabAtual == pool->slabs.size())
+            pool->slabs.push_back((pNodoA*) malloc(POOL_NODOS_POR_SLAB * sizeof(pNodoA)));
+
+        nodo = pool->slabs[pool->slabAtual] + pool->usadosSlab;
+        pool->usadosSlab += 1;
+    }
+
+    pool->vivos += 1;
+    return nodo;
+}
+
+void LiberaNodo(TPoolNodos* pool, pNodoA* nodo)
+{
+    nodo->esq = pool->livres;
+    pool->livres = nodo;
+    pool->vivos -= 1;
+}
+
+void EsvaziaPool(TPoolNodos* pool)
+{
+    // quem guardou ponteiros para nodos deste pool tem que descarta-los
+    AvancaGeracaoArvore();
+    pool->slabAtual = 0;
+    pool->usadosSlab = 0;
+    pool->livres = NULL;
+    pool->vivos = 0;
+}
+
+void DestroiPool(TPoolNodos* pool)
+{
+    for (size_t i = 0; i < pool->slabs.size(); ++i)
+        free(pool->slabs[i]);
+    IniciaPool(pool);
+    AvancaGeracaoArvore();
+}
+
+TEstatisticasPool EstatisticasPool(const TPoolNodos* pool)
+{
+    TEstatisticasPool e;
+    e.vivos = pool->vivos;
+    e.reservados = pool->slabs.size() * POOL_NODOS_POR_SLAB;
+    e.slabs = pool->slabs.size();
+    // todo nodo ja entregue que nao esta vivo esta na lista de livres
+    e.livres = 0;
+    if (!pool->slabs.empty())
+        e.livres = pool->slabAtual * POOL_NODOS_POR_SLAB + pool->usadosSlab - pool->vivos;
+    return e;
+}
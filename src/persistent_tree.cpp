@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <persistent_tree.h>
+
+using namespace std;
+
+static pNodoA* copia(TPoolNodos* pool, const pNodoA* n)
+{
+    pNodoA* c = AlocaNodo(pool);
+    *c = *n;
+    c->sujo = true;
+    return c;
+}
+
+static int altura(const pNodoA* a)
+{
+    return a ? a->altura : 0;
+}
+
+static int tamanho(const pNodoA* a)
+{
+    return a ? a->tamanho : 0;
+}
+
+static void atualizaNodo(pNodoA* a)
+{
+    a->sujo = true;
+    a->altura = max(altura(a->esq), altura(a->dir)) + 1;
+    a->tamanho = tamanho(a->esq) + tamanho(a->dir) + 1;
+}
+
+// As rotacoes recebem "a" ja copiado e copiam o filho que sobe.
+static pNodoA* rotacaoDireita(TPoolNodos* pool, pNodoA* a)
+{
+    pNodoA* b = copia(pool, a->esq);
+    a->esq = b->dir;
+    b->dir = a;
+    atualizaNodo(a);
+    atualizaNodo(b);
+    return b;
+}
+
+static pNodoA* rotacaoEsquerda(TPoolNodos* pool, pNodoA* a)
+{
+    pNodoA* b = copia(pool, a->dir);
+    a->dir = b->esq;
+    b->esq = a;
+    atualizaNodo(a);
+    atualizaNodo(b);
+    return b;
+}
+
+// "a" ja e' uma copia; seus filhos podem ser compartilhados.
+static pNodoA* balanceia(TPoolNodos* pool, pNodoA* a)
+{
+    atualizaNodo(a);
+    int fator = altura(a->esq) - altura(a->dir);
+
+    if (fator > 1) {
+        if (altura(a->esq->esq) < altura(a->esq->dir))
+            a->esq = rotacaoEsquerda(pool, copia(pool, a->esq));
+        return rotacaoDireita(pool, a);
+    }
+    if (fator < -1) {
+        if (altura(a->dir->dir) < altura(a->dir->esq))
+            a->dir = rotacaoDireita(pool, copia(pool, a->dir));
+        return rotacaoEsquerda(pool, a);
+    }
+    return a;
+}
+
+static pNodoA* insere(TPoolNodos* pool, pNodoA* raiz, int ch)
+{
+    if (raiz == NULL) {
+        pNodoA* a = AlocaNodo(pool);
+        a->info = ch;
+        a->esq = NULL;
+        a->dir = NULL;
+        a->currX = 0;
+        a->currY = 0;
+        a->altura = 1;
+        a->tamanho = 1;
+        a->vermelho = false;
+        a->sujo = true;
+        return a;
+    }
+    if (ch == raiz->info)
+        return raiz;
+
+    pNodoA* a = copia(pool, raiz);
+    if (ch < raiz->info)
+        a->esq = insere(pool, raiz->esq, ch);
+    else
+        a->dir = insere(pool, raiz->dir, ch);
+    return balanceia(pool, a);
+}
+
+// Copia o caminho ate o menor nodo de "raiz" e o desliga; "menor" recebe a chave.
+static pNodoA* removeMenor(TPoolNodos* pool, pNodoA* raiz, int* menor)
+{
+    if (raiz->esq == NULL) {
+        *menor = raiz->info;
+        return raiz->dir;
+    }
+    pNodoA* a = copia(pool, raiz);
+    a->esq = removeMenor(pool, raiz->esq, menor);
+    return balanceia(pool, a);
+}
+
+static pNodoA* retira(TPoolNodos* pool, pNodoA* raiz, int ch)
+{
+    if (raiz == NULL)
+        return NULL;
+
+    pNodoA* a;
+    if (ch < raiz->info) {
+        pNodoA* esq = retira(pool, raiz->esq, ch);
+        if (esq == raiz->esq)
+            return raiz; // chave nao encontrada: nada muda
+        a = copia(pool, raiz);
+        a->esq = esq;
+    }
+    else if (ch > raiz->info) {
+        pNodoA* dir = retira(pool, raiz->dir, ch);
+        if (dir == raiz->dir)
+            return raiz;
+        a = copia(pool, raiz);
+        a->dir = dir;
+    }
+    else {
+        if (raiz->esq == NULL)
+            return raiz->dir;
+        if (raiz->dir == NULL)
+            return raiz->esq;
+        a = copia(pool, raiz);
+        a->dir = removeMenor(pool, raiz->dir, &a->info);
+    }
+    return balanceia(pool, a);
+}
+
+// insere() e retira() so' escrevem nos nodos que elas mesmas copiam.
+const pNodoA* InserePersistente(TPoolNodos* pool, const pNodoA* raiz, int ch)
+{
+    return insere(pool, (pNodoA*) raiz, ch);
+}
+
+const pNodoA* RemovePersistente(TPoolNodos* pool, const pNodoA* raiz, int ch)
+{
+    return retira(pool, (pNodoA*) raiz, ch);
+}
+
+pNodoA* CopiaVersao(TPoolNodos* pool, const pNodoA* versao)
+{
+    if (versao == NULL)
+        return NULL;
+
+    pNodoA* raiz = copia(pool, versao);
+    vector<pNodoA*> pilha(1, raiz);
+    while (!pilha.empty()) {
+        pNodoA* n = pilha.back();
+        pilha.pop_back();
+        if (n->esq) {
+            n->esq = copia(pool, n->esq);
+            pilha.push_back(n->esq);
+        }
+        if (n->dir) {
+            n->dir = copia(pool, n->dir);
+            pilha.push_back(n->dir);
+        }
+    }
+    return raiz;
+}
+
+void IniciaHistorico(THistoricoArvore* h)
+{
+    IniciaPool(&h->pool);
+    h->versoes.assign(1, (const pNodoA*) NULL);
+    h->atual = 0;
+}
+
+void DestroiHistorico(THistoricoArvore* h)
+{
+    DestroiPool(&h->pool);
+    h->versoes.assign(1, (const pNodoA*) NULL);
+    h->atual = 0;
+}
+
+static const pNodoA* novaVersao(THistoricoArvore* h, const pNodoA* raiz)
+{
+    if (raiz == VersaoAtual(h))
+        return raiz; // chave repetida ou inexistente: nada mudou
+    h->versoes.resize(h->atual + 1);
+    h->versoes.push_back(raiz);
+    h->atual += 1;
+    return raiz;
+}
+
+const pNodoA* HistoricoInsere(THistoricoArvore* h, int ch)
+{
+    return novaVersao(h, InserePersistente(&h->pool, VersaoAtual(h), ch));
+}
+
+const pNodoA* HistoricoRemove(THistoricoArvore* h, int ch)
+{
+    return novaVersao(h, RemovePersistente(&h->pool, VersaoAtual(h), ch));
+}
+
+const pNodoA* VersaoAtual(const THistoricoArvore* h)
+{
+    return h->versoes[h->atual];
+}
+
+const pNodoA* Versao(const THistoricoArvore* h, size_t i)
+{
+    return h->versoes[i];
+}
+
+bool Desfaz(THistoricoArvore* h)
+{
+    if (h->atual == 0)
+        return false;
+    h->atual -= 1;
+    return true;
+}
+
+bool Refaz(THistoricoArvore* h)
+{
+    if (h->atual + 1 >= h->versoes.size())
+        return false;
+    h->atual += 1;
+    return true;
+}
@@ -0,0 +1,187 @@
+#include <render_queue.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include <glm/gtc/type_ptr.hpp>
+
+// Chave de 40 bits: mistura | programa | VAO | textura | object_id. Nomes
+// OpenGL maiores que o campo so' agrupam pior; a ordem continua valida.
+// Itens com mistura so' tem o bit de cima: entre eles vale o indice, ou
+// seja, a ordem de submissao.
+static unsigned long long chaveItem(const TItemDesenho& item)
+{
+    if (item.mistura)
+        return 1ULL << 39;
+    unsigned long long chave = item.programa & 0x7F;
+    chave = (chave << 12) | (item.vao & 0xFFF);
+    chave = (chave << 12) | (item.textura & 0xFFF);
+    chave = (chave << 8)  | (item.objeto & 0xFF);
+    return chave;
+}
+
+TItemDesenho ItemDesenho(GLuint programa, GLuint vao, GLint objeto, GLenum modo,
+                         GLsizei numIndices, size_t primeiroIndice, const glm::mat4& modelo)
+{
+    TItemDesenho item;
+    item.programa = programa;
+    item.vao = vao;
+    item.textura = 0;
+    item.unidadeTextura = GL_TEXTURE0;
+    item.objeto = objeto;
+    item.instanciado = false;
+    item.mistura = false;
+    item.modo = modo;
+    item.numIndices = numIndices;
+    item.primeiroIndice = primeiroIndice;
+    item.verticeBase = 0;
+    item.instancias = 0;
+    item.modelo = modelo;
+    item.bboxMin = glm::vec3(0.0f);
+    item.bboxMax = glm::vec3(0.0f);
+    return item;
+}
+
+void SubmeteDesenho(TFilaDesenho* f, const TItemDesenho& item)
+{
+    // Indice nos 24 bits de baixo: a ordenacao e' estavel entre chaves iguais.
+    f->chaves.push_back(chaveItem(item) << 24 | f->itens.size());
+    f->itens.push_back(item);
+}
+
+// Estado ja ligado; "valido" falso no inicio de cada execucao, pois o resto
+// do programa pode ter mexido em qualquer coisa entre dois quadros.
+struct TEstadoLigado
+{
+    bool      valido;
+    GLuint    programa;
+    GLuint    vao;
+    GLuint    textura;
+    GLenum    unidadeTextura;
+    GLint     objeto;
+    bool      instanciado;
+    bool      mistura;
+    glm::mat4 modelo;
+    glm::vec3 bboxMin;
+    glm::vec3 bboxMax;
+};
+
+// Dois itens sem instancias que podem ir na mesma chamada de desenho.
+static bool mesmoEstado(const TItemDesenho& a, const TItemDesenho& b)
+{
+    return a.instancias == 0 && b.instancias == 0
+        && a.programa == b.programa && a.vao == b.vao
+        && a.textura == b.textura && a.unidadeTextura == b.unidadeTextura
+        && a.objeto == b.objeto && a.instanciado == b.instanciado
+        && a.mistura == b.mistura && a.modo == b.modo
+        && a.bboxMin == b.bboxMin && a.bboxMax == b.bboxMax
+        && memcmp(&a.modelo, &b.modelo, sizeof(glm::mat4)) == 0;
+}
+
+void ExecutaFilaDesenho(TFilaDesenho* f)
+{
+    TEstatisticasFila& est = f->estatisticas;
+    est.itens = (int) f->itens.size();
+    est.desenhos = est.emitidas = est.puladas = 0;
+
+    std::sort(f->chaves.begin(), f->chaves.end());
+
+    TEstadoLigado e;
+    e.valido = false;
+
+#define MUDA(cond, acao) \
+    if (!e.valido || (cond)) { acao; est.emitidas++; } else est.puladas++;
+
+    for (size_t k = 0; k < f->chaves.size(); )
+    {
+        const TItemDesenho& item = f->itens[f->chaves[k] & 0xFFFFFF];
+
+        // O programa vem antes: os uniforms abaixo sao do programa ligado.
+        bool trocouPrograma = !e.valido || item.programa != e.programa;
+        MUDA(item.programa != e.programa, glUseProgram(item.programa); e.programa = item.programa)
+        if (trocouPrograma)
+            e.valido = false;
+
+        MUDA(item.vao != e.vao, glBindVertexArray(item.vao); e.vao = item.vao)
+
+        if (item.textura != 0)
+        {
+            MUDA(item.textura != e.textura || item.unidadeTextura != e.unidadeTextura,
+                 glActiveTexture(item.unidadeTextura);
+                 glBindTexture(GL_TEXTURE_2D, item.textura);
+                 e.textura = item.textura; e.unidadeTextura = item.unidadeTextura)
+        }
+
+        MUDA(item.objeto != e.objeto, glUniform1i(f->uniformObjeto, item.objeto); e.objeto = item.objeto)
+        MUDA(item.instanciado != e.instanciado,
+             glUniform1i(f->uniformInstanciado, item.instanciado); e.instanciado = item.instanciado)
+        MUDA(item.mistura != e.mistura,
+             if (item.mistura) {
+                 glEnable(GL_BLEND);
+                 glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                 glDisable(GL_CULL_FACE);
+             } else {
+                 glDisable(GL_BLEND);
+                 glEnable(GL_CULL_FACE);
+             }
+             e.mistura = item.mistura)
+        MUDA(memcmp(&item.modelo, &e.modelo, sizeof(glm::mat4)) != 0,
+             glUniformMatrix4fv(f->uniformModelo, 1, GL_FALSE, glm::value_ptr(item.modelo)); e.modelo = item.modelo)
+        MUDA(item.bboxMin != e.bboxMin || item.bboxMax != e.bboxMax,
+             glUniform4f(f->uniformBboxMin, item.bboxMin.x, item.bboxMin.y, item.bboxMin.z, 1.0f);
+             glUniform4f(f->uniformBboxMax, item.bboxMax.x, item.bboxMax.y, item.bboxMax.z, 1.0f);
+             e.bboxMin = item.bboxMin; e.bboxMax = item.bboxMax)
+        e.valido = true;
+
+        // Junta os itens seguintes com o mesmo estado: so' a geometria muda.
+        size_t fim = k + 1;
+        while (fim < f->chaves.size() && mesmoEstado(item, f->itens[f->chaves[fim] & 0xFFFFFF]))
+            fim++;
+
+        if (fim - k > 1)
+        {
+            f->contagens.clear();
+            f->deslocamentos.clear();
+            f->verticesBase.clear();
+            for (size_t j = k; j < fim; j++)
+            {
+                const TItemDesenho& outro = f->itens[f->chaves[j] & 0xFFFFFF];
+                f->contagens.push_back(outro.numIndices);
+                f->deslocamentos.push_back((const void*)(outro.primeiroIndice * sizeof(GLuint)));
+                f->verticesBase.push_back(outro.verticeBase);
+            }
+            glMultiDrawElementsBaseVertex(item.modo, f->contagens.data(), GL_UNSIGNED_INT,
+                                          (void* const*) f->deslocamentos.data(),
+                                          (GLsizei) f->contagens.size(), f->verticesBase.data());
+        }
+        else
+        {
+            void* deslocamento = (void*)(item.primeiroIndice * sizeof(GLuint));
+            if (item.instancias > 0)
+                glDrawElementsInstancedBaseVertex(item.modo, item.numIndices, GL_UNSIGNED_INT,
+                                                  deslocamento, item.instancias, item.verticeBase);
+            else
+                glDrawElementsBaseVertex(item.modo, item.numIndices, GL_UNSIGNED_INT,
+                                         deslocamento, item.verticeBase);
+        }
+        est.desenhos++;
+        k = fim;
+    }
+
+#undef MUDA
+
+    if (e.valido)
+    {
+        glBindVertexArray(0);
+        if (e.mistura)
+        {
+            glDisable(GL_BLEND);
+            glEnable(GL_CULL_FACE);
+        }
+        if (e.instanciado)
+            glUniform1i(f->uniformInstanciado, 0);
+    }
+
+    f->itens.clear();
+    f->chaves.clear();
+}
@@ -13,6 +13,9 @@ in vec4 position_model;
 // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
 in vec2 texcoords;
 
+// Glifo do rótulo sendo desenhado (object_id == TEXTO)
+flat in int glifo;
+
 // Matrizes computadas no código C++ e enviadas para a GPU
 uniform mat4 model;
 uniform mat4 view;
@@ -23,6 +26,7 @@ uniform mat4 projection;
 #define PLANE  2
 #define NUMBER 3
 #define LEAF   4
+#define TEXTO  6
 uniform int object_id;
 
 // Parâmetros da axis-aligned bounding box (AABB) do modelo
@@ -34,6 +38,10 @@ uniform sampler2D TextureImage0;
 uniform sampler2D TextureImage1;
 uniform sampler2D TextureImage2;
 
+// Atlas de campo de distância dos glifos, lado a lado (veja glyph_atlas.h)
+uniform sampler2D AtlasGlifos;
+#define ATLAS_GLIFOS 11
+
 in vec4 cor_interpolada_pelo_rasterizador;
 
 
@@ -148,5 +156,15 @@ void main(){
         // Cor final com correção gamma, considerando monitor sRGB.
         color.rgb = pow(color.rgb, vec3(1.0,1.0,1.0)/2.2);
     }
-} 
-
+    else if (object_id == TEXTO){
+        // 0.5 é a borda do traço; fwidth() dá a largura de um pixel na tela,
+        // para a borda ficar suave em qualquer distância.
+        vec2 uv = vec2((glifo + texcoords.x) / ATLAS_GLIFOS, texcoords.y);
+        float d = texture(AtlasGlifos, uv).r;
+        float w = fwidth(d);
+        float alpha = smoothstep(0.5 - w, 0.5 + w, d);
+        if (alpha <= 0.0)
+            discard;
+        color = vec4(0.05, 0.05, 0.05, alpha);
+    }
+}
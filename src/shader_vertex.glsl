@@ -11,6 +11,54 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Nodos da árvore, desenhados com instâncias (veja renderTree() em
+// "main.cpp"). Cada texel de "animacao" guarda (x0, y0, dx, dy) de um nodo,
+// em pixels, e a posição dele é x0 + dx * suavização(anim_progresso). Com a
+// animação na CPU, (x0, y0) já é a posição atual e anim_progresso é 0.
+// Nesse modo, "model" é só a parte local do objeto (relativa ao centro do
+// nodo, para esferas e dígitos).
+uniform bool nodos_instanciados;
+uniform samplerBuffer animacao;
+uniform float anim_progresso; // (tempo - início) / duração
+uniform float raio_nodo;      // convert_radius_to_unit(nodeCurrentRadius)
+uniform vec2 tela;            // WINDOW_WIDTH, WINDOW_HEIGHT
+layout (location = 3) in ivec2 instancia_nodos; // x: nodo; y: pai (galhos) ou -1
+layout (location = 4) in vec2 instancia_param; // galhos: (ângulo, -); esferas e glifos: (deslocamento em x, escala)
+layout (location = 5) in int instancia_glifo;  // glifos: índice no atlas (glyph_atlas.h)
+
+// Mesma suavização de AvancaAnimacao() e mesma conversão de convert_x_to_unit().
+vec2 posicao_nodo(int i)
+{
+    vec4 a = texelFetch(animacao, i);
+    vec2 p = a.xy + a.zw * smoothstep(0.0, 1.0, anim_progresso);
+    return (p - tela / 2.0) / 100.0;
+}
+
+mat4 translacao(vec3 t)
+{
+    mat4 m = mat4(1.0);
+    m[3] = vec4(t, 1.0);
+    return m;
+}
+
+mat4 rotacao_z(float angulo)
+{
+    float c = cos(angulo);
+    float s = sin(angulo);
+    return mat4(vec4(  c,   s, 0.0, 0.0),
+                vec4( -s,   c, 0.0, 0.0),
+                vec4(0.0, 0.0, 1.0, 0.0),
+                vec4(0.0, 0.0, 0.0, 1.0));
+}
+
+mat4 escala(vec3 s)
+{
+    return mat4(vec4(s.x, 0.0, 0.0, 0.0),
+                vec4(0.0, s.y, 0.0, 0.0),
+                vec4(0.0, 0.0, s.z, 0.0),
+                vec4(0.0, 0.0, 0.0, 1.0));
+}
+
 // Atributos de vértice que serão gerados como saída ("out") pelo Vertex Shader.
 // ** Estes serão interpolados pelo rasterizador! ** gerando, assim, valores
 // para cada fragmento, os quais serão recebidos como entrada pelo Fragment
@@ -19,9 +67,34 @@ out vec4 position_world;
 out vec4 position_model;
 out vec4 normal;
 out vec2 texcoords;
+flat out int glifo;
 
 void main()
 {
+    mat4 modelo = model;
+    if (nodos_instanciados)
+    {
+        vec2 p = posicao_nodo(instancia_nodos.x);
+        if (instancia_nodos.y < 0)
+        {
+            // Glifos encolhidos so' em x e y: o deslocamento em z do rotulo
+            // (que ja' vem em "model") tem que continuar fora da esfera.
+            modelo = translacao(vec3(p, 0.0)) * escala(vec3(raio_nodo))
+                   * translacao(vec3(instancia_param.x, 0.0, 0.0))
+                   * escala(vec3(instancia_param.y, instancia_param.y, 1.0)) * modelo;
+        }
+        else
+        {
+            // Galho entre o nodo e o pai.
+            vec2 q = posicao_nodo(instancia_nodos.y);
+            vec3 s = vec3(abs(q - p) / 4.0, 0.2);
+            // Escondido enquanto o filho se move.
+            if (anim_progresso < 1.0 && texelFetch(animacao, instancia_nodos.x).zw != vec2(0.0))
+                s = vec3(0.0);
+            modelo = translacao(vec3((p + q) / 2.0, 0.0)) * escala(s) * rotacao_z(instancia_param.x) * modelo;
+        }
+    }
+
     // A variável gl_Position define a posição final de cada vértice
     // OBRIGATORIAMENTE em "normalized device coordinates" (NDC), onde cada
     // coeficiente estará entre -1 e 1 após divisão por w.
@@ -34,7 +107,7 @@ void main()
     // deste Vertex Shader, a placa de vídeo (GPU) fará a divisão por W. Veja
     // slides 41-67 e 69-86 do documento Aula_09_Projecoes.pdf.
 
-    gl_Position = projection * view * model * model_coefficients;
+    gl_Position = projection * view * modelo * model_coefficients;
 
     // Como as variáveis acima  (tipo vec4) são vetores com 4 coeficientes,
     // também é possível acessar e modificar cada coeficiente de maneira
@@ -51,17 +124,19 @@ void main()
     // rasterizador para gerar atributos únicos para cada fragmento gerado.
 
     // Posição do vértice atual no sistema de coordenadas global (World).
-    position_world = model * model_coefficients;
+    position_world = modelo * model_coefficients;
 
     // Posição do vértice atual no sistema de coordenadas local do modelo.
     position_model = model_coefficients;
 
     // Normal do vértice atual no sistema de coordenadas global (World).
     // Veja slides 123-151 do documento Aula_07_Transformacoes_Geometricas_3D.pdf.
-    normal = inverse(transpose(model)) * normal_coefficients;
+    normal = inverse(transpose(modelo)) * normal_coefficients;
     normal.w = 0.0;
 
     // Coordenadas de textura obtidas do arquivo OBJ (se existirem!)
     texcoords = texture_coefficients;
+
+    glifo = instancia_glifo;
 }
 
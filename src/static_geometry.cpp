@@ -0,0 +1,79 @@
+#include <static_geometry.h>
+
+void IniciaGeometriaEstatica(TGeometriaEstatica* g)
+{
+    g->posicoes.clear();
+    g->normais.clear();
+    g->texcoords.clear();
+    g->indices.clear();
+    glGenVertexArrays(1, &g->vao);
+    glGenBuffers(4, g->buffers);
+}
+
+TTrechoGeometria AcrescentaMalha(TGeometriaEstatica* g,
+                                 const float* posicoes, const float* normais, const float* texcoords,
+                                 size_t numVertices, const GLuint* indices, size_t numIndices)
+{
+    TTrechoGeometria trecho;
+    trecho.primeiroIndice = g->indices.size();
+    trecho.numIndices = numIndices;
+    trecho.verticeBase = (GLint)(g->posicoes.size() / 4);
+
+    g->posicoes.insert(g->posicoes.end(), posicoes, posicoes + 4*numVertices);
+    if (normais)
+        g->normais.insert(g->normais.end(), normais, normais + 4*numVertices);
+    else
+        g->normais.resize(g->normais.size() + 4*numVertices, 0.0f);
+    if (texcoords)
+        g->texcoords.insert(g->texcoords.end(), texcoords, texcoords + 2*numVertices);
+    else
+        g->texcoords.resize(g->texcoords.size() + 2*numVertices, 0.0f);
+    g->indices.insert(g->indices.end(), indices, indices + numIndices);
+
+    return trecho;
+}
+
+// Liga os buffers de vertices e de indices ao VAO ligado no momento.
+static void ligaAtributos(const TGeometriaEstatica* g)
+{
+    static const GLint dimensoes[3] = { 4, 4, 2 }; // vec4, vec4, vec2 em "shader_vertex.glsl"
+    for (GLuint location = 0; location < 3; location++)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, g->buffers[location]);
+        glVertexAttribPointer(location, dimensoes[location], GL_FLOAT, GL_FALSE, 0, 0);
+        glEnableVertexAttribArray(location);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g->buffers[3]);
+}
+
+void EnviaGeometriaEstatica(TGeometriaEstatica* g)
+{
+    const std::vector<float>* dados[3] = { &g->posicoes, &g->normais, &g->texcoords };
+    for (int i = 0; i < 3; i++)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, g->buffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, dados[i]->size() * sizeof(float), dados[i]->data(), GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindVertexArray(g->vao);
+    ligaAtributos(g);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, g->indices.size() * sizeof(GLuint), g->indices.data(), GL_STATIC_DRAW);
+    glBindVertexArray(0);
+
+    std::vector<float>().swap(g->posicoes);
+    std::vector<float>().swap(g->normais);
+    std::vector<float>().swap(g->texcoords);
+    std::vector<GLuint>().swap(g->indices);
+}
+
+GLuint CriaVaoGeometria(const TGeometriaEstatica* g)
+{
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    ligaAtributos(g);
+    glBindVertexArray(0);
+    return vao;
+}
@@ -0,0 +1,193 @@
+#include <cstdlib>
+#include <vector>
+#include <tidy_layout.h>
+
+using namespace std;
+
+// Separacao minima entre nodos vizinhos, em unidades inteiras.
+#define SEPARACAO_MIN 2
+
+// Nodo extremo (mais a esquerda ou mais a direita no nivel mais fundo) de
+// uma subarvore, com seu deslocamento em relacao a raiz dela.
+struct TExtremo
+{
+    int nodo;
+    long desl;
+    int nivel;
+};
+
+// Vetores indexados pela posicao do nodo em pre-ordem. Reaproveitados.
+static vector<pNodoA*> nodos;
+static vector<int> filhoEsq, filhoDir; // filhos originais
+static vector<int> ligEsq, ligDir;     // filhos, mais as "threads" do contorno
+static vector<long> desl;              // distancia de cada filho ao pai
+static vector<long> pos;
+static vector<int> nivel;
+static vector<TExtremo> maisEsq, maisDir;
+
+// Numera os nodos em pre-ordem. Com o tamanho das subarvores, o filho
+// esquerdo de i e' i+1 e o direito i+1+tamanho(esq).
+static void numera(pNodoA* raiz)
+{
+    static TPercurso percurso;
+    nodos.clear();
+    IniciaPercurso(&percurso, raiz, PERCURSO_PRE);
+    for (pNodoA* n = ProximoNodo(&percurso); n != NULL; n = ProximoNodo(&percurso))
+        nodos.push_back(n);
+
+    size_t n = nodos.size();
+    filhoEsq.resize(n);
+    filhoDir.resize(n);
+    desl.resize(n);
+    pos.resize(n);
+    nivel.resize(n);
+    maisEsq.resize(n);
+    maisDir.resize(n);
+
+    nivel[0] = 1;
+    for (size_t i = 0; i < n; i++) {
+        pNodoA* a = nodos[i];
+        int esq = a->esq ? (int) i + 1 : -1;
+        int dir = a->dir ? (int) i + 1 + tamanhoArvore(a->esq) : -1;
+        filhoEsq[i] = esq;
+        filhoDir[i] = dir;
+        if (esq >= 0)
+            nivel[esq] = nivel[i] + 1;
+        if (dir >= 0)
+            nivel[dir] = nivel[i] + 1;
+    }
+    ligEsq = filhoEsq;
+    ligDir = filhoDir;
+}
+
+// Passo de baixo para cima (o "setup" do artigo): aproxima as duas
+// subarvores de cada nodo o quanto os contornos permitem. Os contornos sao
+// seguidos pelas threads, entao cada nodo e' visitado O(1) vezes no total.
+static void afasta(int t)
+{
+    int L = ligEsq[t], R = ligDir[t];
+    if (L < 0 && R < 0) {
+        TExtremo folha = { t, 0, nivel[t] };
+        maisEsq[t] = folha;
+        maisDir[t] = folha;
+        desl[t] = 0;
+        return;
+    }
+
+    TExtremo vazio = { -1, 0, -1 };
+    TExtremo LL = L >= 0 ? maisEsq[L] : vazio, LR = L >= 0 ? maisDir[L] : vazio;
+    TExtremo RL = R >= 0 ? maisEsq[R] : vazio, RR = R >= 0 ? maisDir[R] : vazio;
+
+    // desce pelo contorno direito de L e esquerdo de R ao mesmo tempo
+    long sepAtual = SEPARACAO_MIN, sepRaiz = SEPARACAO_MIN;
+    long somaEsq = 0, somaDir = 0;
+    while (L >= 0 && R >= 0) {
+        if (sepAtual < SEPARACAO_MIN) {
+            sepRaiz += SEPARACAO_MIN - sepAtual;
+            sepAtual = SEPARACAO_MIN;
+        }
+        if (ligDir[L] >= 0) {
+            somaEsq += desl[L];
+            sepAtual -= desl[L];
+            L = ligDir[L];
+        }
+        else {
+            somaEsq -= desl[L];
+            sepAtual += desl[L];
+            L = ligEsq[L];
+        }
+        if (ligEsq[R] >= 0) {
+            somaDir -= desl[R];
+            sepAtual -= desl[R];
+            R = ligEsq[R];
+        }
+        else {
+            somaDir += desl[R];
+            sepAtual += desl[R];
+            R = ligDir[R];
+        }
+    }
+
+    desl[t] = (sepRaiz + 1) / 2;
+    somaEsq -= desl[t];
+    somaDir += desl[t];
+
+    if (RL.nivel > LL.nivel || filhoEsq[t] < 0) {
+        maisEsq[t] = RL;
+        maisEsq[t].desl += desl[t];
+    }
+    else {
+        maisEsq[t] = LL;
+        maisEsq[t].desl -= desl[t];
+    }
+    if (LR.nivel > RR.nivel || filhoDir[t] < 0) {
+        maisDir[t] = LR;
+        maisDir[t].desl -= desl[t];
+    }
+    else {
+        maisDir[t] = RR;
+        maisDir[t].desl += desl[t];
+    }
+
+    // A subarvore mais rasa continua o contorno pela mais funda: o extremo
+    // dela (uma folha) ganha uma thread para o proximo nodo do contorno.
+    if (L >= 0 && L != filhoEsq[t]) {
+        int a = RR.nodo;
+        desl[a] = labs((RR.desl + desl[t]) - somaEsq);
+        if (somaEsq - desl[t] <= RR.desl)
+            ligEsq[a] = L;
+        else
+            ligDir[a] = L;
+    }
+    else if (R >= 0 && R != filhoDir[t]) {
+        int a = LL.nodo;
+        desl[a] = labs((LL.desl - desl[t]) - somaDir);
+        if (somaDir + desl[t] >= LL.desl)
+            ligDir[a] = R;
+        else
+            ligEsq[a] = R;
+    }
+}
+
+void LayoutArrumado(pNodoA* raiz, double largura, double altura, double separacao)
+{
+    if (raiz == NULL)
+        return;
+
+    numera(raiz);
+    int n = (int) nodos.size();
+
+    // filhos tem indice maior que o pai: de tras para frente e' pos-ordem
+    for (int t = n - 1; t >= 0; t--)
+        afasta(t);
+
+    // posicoes absolutas, de cima para baixo, pelos filhos originais
+    long menor = 0, maior = 0;
+    int niveis = 1;
+    pos[0] = 0;
+    for (int i = 0; i < n; i++) {
+        if (filhoEsq[i] >= 0)
+            pos[filhoEsq[i]] = pos[i] - desl[i];
+        if (filhoDir[i] >= 0)
+            pos[filhoDir[i]] = pos[i] + desl[i];
+        if (pos[i] < menor)
+            menor = pos[i];
+        if (pos[i] > maior)
+            maior = pos[i];
+        if (nivel[i] > niveis)
+            niveis = nivel[i];
+    }
+
+    double escala = separacao / SEPARACAO_MIN;
+    double centro = (menor + maior) / 2.0;
+    double levelHeight = altura / niveis;
+    if (levelHeight < separacao)
+        levelHeight = separacao;
+    for (int i = 0; i < n; i++) {
+        pNodoA* a = nodos[i];
+        a->level = nivel[i];
+        a->x = largura / 2 + (pos[i] - centro) * escala;
+        a->y = altura - (nivel[i] * levelHeight - levelHeight / 2);
+        a->sujo = false;
+    }
+}
@@ -1,23 +1,281 @@
 #include<iostream>
+#include<vector>
+#include<algorithm>
+#include<thread>
 #include<tree.h>
+#include<node_pool.h>
 using namespace std;
+
+static int modoArvore = ARVORE_ABP;
+static RotacaoCallback callbackRotacao = NULL;
+static TPoolNodos poolPadrao = TPoolNodos();
+static TPoolNodos* poolArvore = &poolPadrao;
+static unsigned long geracaoArvore = 0;
+
+void DefineModoArvore(int modo)
+{
+    modoArvore = modo;
+}
+
+int ModoArvore()
+{
+    return modoArvore;
+}
+
+void DefineCallbackRotacao(RotacaoCallback callback)
+{
+    callbackRotacao = callback;
+}
+
+void DefinePoolArvore(TPoolNodos* pool)
+{
+    poolArvore = pool;
+}
+
+TPoolNodos* PoolArvore()
+{
+    return poolArvore;
+}
+
+unsigned long GeracaoArvore()
+{
+    return geracaoArvore;
+}
+
+void AvancaGeracaoArvore()
+{
+    geracaoArvore++;
+}
+
+static pNodoA* novoNodo(int ch)
+{
+    pNodoA* a = AlocaNodo(poolArvore);
+    a->info = ch;
+    a->esq = NULL;
+    a->dir = NULL;
+    a->currX = 0;
+    a->currY = 0;
+    a->altura = 1;
+    a->tamanho = 1;
+    a->vermelho = true;
+    a->sujo = true;
+    return a;
+}
+
+static int altura(pNodoA* a)
+{
+    return a ? a->altura : 0;
+}
+
+static int tamanho(pNodoA* a)
+{
+    return a ? a->tamanho : 0;
+}
+
+// Recalcula altura e tamanho de "a" a partir dos filhos, que ja estao corretos.
+// Todo nodo cujos filhos mudaram passa por aqui, e fica marcado como sujo.
+static void atualizaNodo(pNodoA* a)
+{
+    a->sujo = true;
+    a->altura = max(altura(a->esq), altura(a->dir)) + 1;
+    a->tamanho = tamanho(a->esq) + tamanho(a->dir) + 1;
+}
+
+static bool ehVermelho(pNodoA* a)
+{
+    return a != NULL && a->vermelho;
+}
+
+static pNodoA* rotacaoDireita(pNodoA* a)
+{
+    pNodoA* b = a->esq;
+    a->esq = b->dir;
+    b->dir = a;
+
+    // a cor sobe junto com a posicao; so importa no modo rubro-negro
+    b->vermelho = a->vermelho;
+    a->vermelho = true;
+
+    atualizaNodo(a);
+    atualizaNodo(b);
+    if (callbackRotacao)
+        callbackRotacao(a, b);
+    return b;
+}
+
+static pNodoA* rotacaoEsquerda(pNodoA* a)
+{
+    pNodoA* b = a->dir;
+    a->dir = b->esq;
+    b->esq = a;
+
+    b->vermelho = a->vermelho;
+    a->vermelho = true;
+
+    atualizaNodo(a);
+    atualizaNodo(b);
+    if (callbackRotacao)
+        callbackRotacao(a, b);
+    return b;
+}
+
+/* AVL */
+
+static pNodoA* balanceiaAVL(pNodoA* a)
+{
+    atualizaNodo(a);
+    int fator = altura(a->esq) - altura(a->dir);
+
+    if (fator > 1) {
+        if (altura(a->esq->esq) < altura(a->esq->dir))
+            a->esq = rotacaoEsquerda(a->esq);
+        return rotacaoDireita(a);
+    }
+    if (fator < -1) {
+        if (altura(a->dir->dir) < altura(a->dir->esq))
+            a->dir = rotacaoDireita(a->dir);
+        return rotacaoEsquerda(a);
+    }
+    return a;
+}
+
+/* Rubro-negra (left-leaning, Sedgewick 2008) */
+
+static void inverteCores(pNodoA* a)
+{
+    a->vermelho = !a->vermelho;
+    a->esq->vermelho = !a->esq->vermelho;
+    a->dir->vermelho = !a->dir->vermelho;
+}
+
+static pNodoA* corrigeRN(pNodoA* a)
+{
+    if (ehVermelho(a->dir) && !ehVermelho(a->esq))
+        a = rotacaoEsquerda(a);
+    if (ehVermelho(a->esq) && ehVermelho(a->esq->esq))
+        a = rotacaoDireita(a);
+    if (ehVermelho(a->esq) && ehVermelho(a->dir))
+        inverteCores(a);
+    atualizaNodo(a);
+    return a;
+}
+
+static pNodoA* moveVermelhoEsquerda(pNodoA* a)
+{
+    inverteCores(a);
+    if (ehVermelho(a->dir->esq)) {
+        a->dir = rotacaoDireita(a->dir);
+        a = rotacaoEsquerda(a);
+        inverteCores(a);
+    }
+    return a;
+}
+
+static pNodoA* moveVermelhoDireita(pNodoA* a)
+{
+    inverteCores(a);
+    if (ehVermelho(a->esq->esq)) {
+        a = rotacaoDireita(a);
+        inverteCores(a);
+    }
+    return a;
+}
+
+static pNodoA* insereRN(pNodoA* a, int ch)
+{
+    if (a == NULL)
+        return novoNodo(ch);
+
+    if (ch < a->info)
+        a->esq = insereRN(a->esq, ch);
+    else if (ch > a->info)
+        a->dir = insereRN(a->dir, ch);
+    else
+        return a;
+
+    return corrigeRN(a);
+}
+
+static pNodoA* removeMinRN(pNodoA* a)
+{
+    // numa LLRB o menor nodo nunca tem filho a direita
+    if (a->esq == NULL) {
+        LiberaNodo(poolArvore, a);
+        return NULL;
+    }
+    if (!ehVermelho(a->esq) && !ehVermelho(a->esq->esq))
+        a = moveVermelhoEsquerda(a);
+    a->esq = removeMinRN(a->esq);
+    return corrigeRN(a);
+}
+
+// Assume que "ch" esta na arvore.
+static pNodoA* removeRN(pNodoA* a, int ch)
+{
+    if (ch < a->info) {
+        if (!ehVermelho(a->esq) && !ehVermelho(a->esq->esq))
+            a = moveVermelhoEsquerda(a);
+        a->esq = removeRN(a->esq, ch);
+    }
+    else {
+        if (ehVermelho(a->esq))
+            a = rotacaoDireita(a);
+        if (ch == a->info && a->dir == NULL) {
+            LiberaNodo(poolArvore, a);
+            return NULL;
+        }
+        if (!ehVermelho(a->dir) && !ehVermelho(a->dir->esq))
+            a = moveVermelhoDireita(a);
+        if (ch == a->info) {
+            a->info = minValor(a->dir)->info;
+            a->dir = removeMinRN(a->dir);
+        }
+        else
+            a->dir = removeRN(a->dir, ch);
+    }
+    return corrigeRN(a);
+}
+
+// Links (ponteiros para o campo que aponta o nodo) do caminho da raiz ate o
+// ponto de insercao/remocao. Reaproveitado entre chamadas.
+static vector<pNodoA**> caminho;
+
+// Refaz altura/tamanho (e, na AVL, o balanceamento) subindo pelo caminho.
+static void corrigeCaminho()
+{
+    for (size_t i = caminho.size(); i-- > 0; )
+    {
+        pNodoA** link = caminho[i];
+        if (modoArvore == ARVORE_AVL)
+            *link = balanceiaAVL(*link);
+        else
+            atualizaNodo(*link);
+    }
+}
+
 pNodoA* InsereArvore(pNodoA *a, int ch)
 {
-     if (a == NULL)
+     geracaoArvore++;
+     if (modoArvore == ARVORE_RN)
      {
-         a =  (pNodoA*) malloc(sizeof(pNodoA));
-         a->info = ch;
-         a->esq = NULL;
-         a->dir = NULL;
-         a->currX = 0;
-         a->currY = 0;
+         // recursiva: a altura da rubro-negra e' no maximo 2 log n
+         a = insereRN(a, ch);
+         a->vermelho = false;
          return a;
      }
-     else
-          if (ch < a->info)
-              a->esq = InsereArvore(a->esq,ch);
-          else if (ch > a->info)
-              a->dir = InsereArvore(a->dir,ch);
+
+     caminho.clear();
+     pNodoA** link = &a;
+     while (*link != NULL)
+     {
+          if (ch == (*link)->info)
+              return a;
+          caminho.push_back(link);
+          link = ch < (*link)->info ? &(*link)->esq : &(*link)->dir;
+     }
+     *link = novoNodo(ch);
+
+     corrigeCaminho();
      return a;
 }
 
@@ -36,69 +294,480 @@ pNodoA* consultaABP(pNodoA *a, int chave) {
             return NULL; 
 }
 
+// Numero de buscas intercaladas por consultaABPBatch.
+#define CONSULTA_VIAS 16
+
+void consultaABPBatch(pNodoA *a, const int* chaves, int n, pNodoA** resultados)
+{
+    // Cada via segue uma busca. A cada passo avancamos todas as vias um nivel
+    // e pedimos o proximo nodo de cada uma com prefetch: ate ele ser lido,
+    // as outras vias ja andaram, e as faltas de cache se sobrepoem. Quando
+    // uma busca termina a via recomeca da raiz com a proxima chave.
+    pNodoA* via[CONSULTA_VIAS];
+    int chaveDaVia[CONSULTA_VIAS];
+    int proxima = 0;
+    int ativas = 0;
+
+    if (a == NULL) {
+        for (int i = 0; i < n; i++)
+            resultados[i] = NULL;
+        return;
+    }
+
+    for (int v = 0; v < CONSULTA_VIAS; v++) {
+        chaveDaVia[v] = proxima < n ? proxima++ : -1;
+        via[v] = a;
+        if (chaveDaVia[v] >= 0)
+            ativas++;
+    }
+
+    while (ativas > 0) {
+        for (int v = 0; v < CONSULTA_VIAS; v++) {
+            int k = chaveDaVia[v];
+            if (k < 0)
+                continue;
+
+            pNodoA* p = via[v];
+            int ch = chaves[k];
+            pNodoA* prox = p->info > ch ? p->esq : p->dir;
+
+            if (p->info == ch || prox == NULL) {
+                resultados[k] = p->info == ch ? p : NULL;
+                if (proxima < n) {
+                    chaveDaVia[v] = proxima++;
+                    via[v] = a;
+                }
+                else {
+                    chaveDaVia[v] = -1;
+                    ativas--;
+                }
+            }
+            else {
+                __builtin_prefetch(prox);
+                via[v] = prox;
+            }
+        }
+    }
+}
+
 pNodoA* minValor(pNodoA* node)
 {
     struct TNodoA* current = node;
-  
+
     /* loop down to find the leftmost leaf */
     while (current && current->esq != NULL)
         current = current->esq;
-  
+
     return current;
 }
 
 pNodoA* RemoveArvore(pNodoA *a, int ch)
 {
-      // base case
-    if (a == NULL)
+    geracaoArvore++;
+    if (modoArvore == ARVORE_RN)
+    {
+        if (consultaABP(a, ch) == NULL)
+            return a;
+        // a raiz e' sempre preta; pintamos de vermelho para que a descida
+        // tenha sempre um nodo vermelho a ser empurrado para baixo
+        if (!ehVermelho(a->esq) && !ehVermelho(a->dir))
+            a->vermelho = true;
+        a = removeRN(a, ch);
+        if (a)
+            a->vermelho = false;
         return a;
-  
-    // If the ch to be deleted is 
-    // smaller than the a's
-    // ch, then it lies in esq subtree
-    if (ch < a->info)
-        a->esq = RemoveArvore(a->esq, ch);
-  
-    // If the ch to be deleted is
-    // greater than the a's
-    // ch, then it lies in dir subtree
-    else if (ch > a->info)
-        a->dir = RemoveArvore(a->dir, ch);
-  
-    // if ch is same as a's ch, then This is the node
-    // to be deleted
-    else {
-        // node has no child
-        if (a->esq==NULL and a->dir==NULL)
-            return NULL;
-        
+    }
+
+    caminho.clear();
+    pNodoA** link = &a;
+    while (*link != NULL && (*link)->info != ch)
+    {
+        caminho.push_back(link);
+        link = ch < (*link)->info ? &(*link)->esq : &(*link)->dir;
+    }
+    if (*link == NULL)
+        return a;
+
+    pNodoA* nodo = *link;
+    if (nodo->esq != NULL && nodo->dir != NULL)
+    {
+        // node with two children: Get the inorder successor
+        // (smallest in the dir subtree), copy its content to this node
+        // and unlink the successor instead
+        caminho.push_back(link);
+        link = &nodo->dir;
+        while ((*link)->esq != NULL)
+        {
+            caminho.push_back(link);
+            link = &(*link)->esq;
+        }
+        pNodoA* sucessor = *link;
+        nodo->info = sucessor->info;
+        *link = sucessor->dir;
+        LiberaNodo(poolArvore, sucessor);
+    }
+    else
+    {
         // node with only one child or no child
-        else if (a->esq == NULL) {
-            struct TNodoA* temp = a->dir;
-            free(a);
-            return temp;
+        *link = nodo->esq != NULL ? nodo->esq : nodo->dir;
+        LiberaNodo(poolArvore, nodo);
+    }
+
+    corrigeCaminho();
+    return a;
+}
+
+/* Construcao em lote */
+
+// Arvore perfeitamente balanceada com as chaves ordenadas [ini, fim).
+static pNodoA* constroiBalanceada(const int* ini, const int* fim)
+{
+    if (ini == fim)
+        return NULL;
+    const int* meio = ini + (fim - ini) / 2;
+    pNodoA* a = novoNodo(*meio);
+    a->vermelho = false;
+    a->esq = constroiBalanceada(ini, meio);
+    a->dir = constroiBalanceada(meio + 1, fim);
+    atualizaNodo(a);
+    return a;
+}
+
+// Maior numero de chaves numa arvore 2-3 com todas as folhas a "h" niveis.
+static long maxChaves23(int h)
+{
+    long m = 1;
+    for (int i = 0; i < h; i++)
+        m *= 3;
+    return m - 1;
+}
+
+// Rubro-negra com as chaves ordenadas [ini, fim) e altura preta "h". A
+// arvore e' montada como a arvore 2-3 equivalente: cada nodo 2-3 vira um
+// nodo preto (com 1 chave) ou um preto com filho vermelho a esquerda (com
+// 2 chaves), e as chaves sao repartidas para que todas as folhas fiquem no
+// mesmo nivel. Requer 2^h - 1 <= (fim - ini) <= 3^h - 1.
+static pNodoA* constroiRN(const int* ini, const int* fim, int h)
+{
+    long m = fim - ini;
+    if (m == 0)
+        return NULL;
+
+    long maxFilho = maxChaves23(h - 1);
+    pNodoA* a;
+    if (m - 1 <= 2 * maxFilho) {
+        const int* k = ini + (m - 1) / 2;
+        a = novoNodo(*k);
+        a->esq = constroiRN(ini, k, h - 1);
+        a->dir = constroiRN(k + 1, fim, h - 1);
+    }
+    else {
+        long t1 = (m - 2) / 3;
+        long t2 = (m - 2 - t1) / 2;
+        const int* k1 = ini + t1;
+        const int* k2 = k1 + 1 + t2;
+        pNodoA* v = novoNodo(*k1);
+        v->esq = constroiRN(ini, k1, h - 1);
+        v->dir = constroiRN(k1 + 1, k2, h - 1);
+        atualizaNodo(v);
+        a = novoNodo(*k2);
+        a->esq = v;
+        a->dir = constroiRN(k2 + 1, fim, h - 1);
+    }
+    a->vermelho = false;
+    atualizaNodo(a);
+    return a;
+}
+
+// Ordena "v" em paralelo: cada thread ordena um pedaco, e os pedacos sao
+// intercalados dois a dois.
+static void ordenaParalelo(vector<int>& v)
+{
+    size_t partes = thread::hardware_concurrency();
+    if (partes < 2 || v.size() < 2 * partes)
+    {
+        sort(v.begin(), v.end());
+        return;
+    }
+
+    vector<size_t> limites;
+    for (size_t i = 0; i <= partes; i++)
+        limites.push_back(v.size() * i / partes);
+
+    vector<thread> threads;
+    for (size_t i = 0; i < partes; i++)
+        threads.push_back(thread([&v, &limites, i]() {
+            sort(v.begin() + limites[i], v.begin() + limites[i + 1]);
+        }));
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+
+    for (size_t passo = 1; passo < partes; passo *= 2)
+        for (size_t i = 0; i + passo < partes; i += 2 * passo)
+        {
+            size_t fim = min(i + 2 * passo, partes);
+            inplace_merge(v.begin() + limites[i], v.begin() + limites[i + passo], v.begin() + limites[fim]);
+        }
+}
+
+pNodoA* ConstroiArvore(const int* chaves, int n, bool ordenadas, bool ordenacaoParalela)
+{
+    geracaoArvore++;
+    vector<int> v(chaves, chaves + n);
+    if (!ordenadas) {
+        if (ordenacaoParalela)
+            ordenaParalelo(v);
+        else
+            sort(v.begin(), v.end());
+    }
+    v.erase(unique(v.begin(), v.end()), v.end());
+
+    if (modoArvore != ARVORE_RN)
+        return constroiBalanceada(v.data(), v.data() + v.size());
+
+    // maior h com 2^h - 1 <= n
+    int h = 0;
+    while ((2L << h) - 1 <= (long) v.size())
+        h++;
+    return constroiRN(v.data(), v.data() + v.size(), h);
+}
+
+pNodoA* ReconstroiArvore(pNodoA *a)
+{
+    geracaoArvore++;
+    pNodoA* nova = NULL;
+    vector<pNodoA*> pilha;
+    if (a)
+        pilha.push_back(a);
+
+    // pre-ordem: no modo ABP a forma da arvore original e' preservada
+    while (!pilha.empty()) {
+        pNodoA* n = pilha.back();
+        pilha.pop_back();
+        if (n->dir)
+            pilha.push_back(n->dir);
+        if (n->esq)
+            pilha.push_back(n->esq);
+
+        nova = InsereArvore(nova, n->info);
+        pNodoA* copia = consultaABP(nova, n->info);
+        copia->currX = n->currX;
+        copia->currY = n->currY;
+        LiberaNodo(poolArvore, n);
+    }
+    return nova;
+}
+
+void LiberaArvore(pNodoA *a)
+{
+    geracaoArvore++;
+    vector<pNodoA*> pilha;
+    if (a)
+        pilha.push_back(a);
+
+    while (!pilha.empty()) {
+        pNodoA* n = pilha.back();
+        pilha.pop_back();
+        if (n->esq)
+            pilha.push_back(n->esq);
+        if (n->dir)
+            pilha.push_back(n->dir);
+        LiberaNodo(poolArvore, n);
+    }
+}
+
+int alturaArvore(pNodoA* a)
+{
+    return altura(a);
+}
+
+int tamanhoArvore(pNodoA* a)
+{
+    return tamanho(a);
+}
+
+int fatorBalanceamento(pNodoA* a)
+{
+    return a ? altura(a->esq) - altura(a->dir) : 0;
+}
+
+// Rank e selecao descem pela arvore usando "tamanho" (numero de nodos da
+// subarvore), mantido em cada nodo por InsereArvore/RemoveArvore.
+int rankArvore(pNodoA* a, int ch)
+{
+    int menores = 0;
+    while (a != NULL) {
+        if (ch <= a->info)
+            a = a->esq;
+        else {
+            menores += tamanho(a->esq) + 1;
+            a = a->dir;
+        }
+    }
+    return menores;
+}
+
+pNodoA* selecionaArvore(pNodoA* a, int k)
+{
+    while (a != NULL) {
+        int t = tamanho(a->esq);
+        if (k == t)
+            return a;
+        if (k < t)
+            a = a->esq;
+        else {
+            k -= t + 1;
+            a = a->dir;
         }
-        else if (a->dir == NULL) {
-            struct TNodoA* temp = a->esq;
-            free(a);
-            return temp;
+    }
+    return NULL;
+}
+
+// Quantas chaves sao <= ch.
+static int contaAte(pNodoA* a, int ch)
+{
+    int n = 0;
+    while (a != NULL) {
+        if (ch < a->info)
+            a = a->esq;
+        else {
+            n += tamanho(a->esq) + 1;
+            a = a->dir;
         }
-  
-        // node with two children: Get the inorder successor
-        // (smallest in the dir subtree)
-        struct TNodoA* temp = minValor(a->dir);
-  
-        // Copy the inorder successor's content to this node
-        a->info = temp->info;
-  
-        // Delete the inorder successor
-        a->dir = RemoveArvore(a->dir, temp->info);
     }
-    return a;
+    return n;
+}
+
+int contaIntervalo(pNodoA* a, int lo, int hi)
+{
+    if (lo > hi)
+        return 0;
+    return contaAte(a, hi) - rankArvore(a, lo);
 }
 
 int getLevel(pNodoA* currNode) {
-	if (currNode == NULL)
-		return 0;
-	return max(getLevel(currNode->esq) + 1, getLevel(currNode->dir) + 1);
-}
\ No newline at end of file
+	return alturaArvore(currNode);
+}
+
+/* Percursos iterativos */
+
+void IniciaPercurso(TPercurso* p, pNodoA* raiz, int ordem)
+{
+    p->pilha.clear();
+    // no pior caso a pilha guarda um nodo por nivel (a fila, a arvore toda)
+    p->pilha.reserve(ordem == PERCURSO_NIVEL ? tamanhoArvore(raiz) : alturaArvore(raiz) + 1);
+    p->inicioFila = 0;
+    p->ordem = ordem;
+    p->atual = NULL;
+    p->anterior = NULL;
+
+    if (ordem == PERCURSO_EM || ordem == PERCURSO_POS)
+        p->atual = raiz;
+    else if (raiz != NULL)
+        p->pilha.push_back(raiz);
+}
+
+pNodoA* ProximoNodo(TPercurso* p)
+{
+    pNodoA* n;
+    switch (p->ordem)
+    {
+        case PERCURSO_PRE:
+            // os filhos do ultimo nodo so sao empilhados agora, para que
+            // PulaFilhos() possa descarta-los
+            if (p->anterior != NULL) {
+                if (p->anterior->dir)
+                    p->pilha.push_back(p->anterior->dir);
+                if (p->anterior->esq)
+                    p->pilha.push_back(p->anterior->esq);
+            }
+            if (p->pilha.empty())
+                return p->anterior = NULL;
+            n = p->pilha.back();
+            p->pilha.pop_back();
+            p->anterior = n;
+            return n;
+
+        case PERCURSO_EM:
+            while (p->atual != NULL) {
+                p->pilha.push_back(p->atual);
+                p->atual = p->atual->esq;
+            }
+            if (p->pilha.empty())
+                return NULL;
+            n = p->pilha.back();
+            p->pilha.pop_back();
+            p->atual = n->dir;
+            return n;
+
+        case PERCURSO_POS:
+            for (;;) {
+                while (p->atual != NULL) {
+                    p->pilha.push_back(p->atual);
+                    p->atual = p->atual->esq;
+                }
+                if (p->pilha.empty())
+                    return NULL;
+                n = p->pilha.back();
+                if (n->dir != NULL && p->anterior != n->dir) {
+                    p->atual = n->dir;
+                    continue;
+                }
+                p->pilha.pop_back();
+                p->anterior = n;
+                return n;
+            }
+
+        case PERCURSO_NIVEL:
+            if (p->inicioFila == p->pilha.size())
+                return NULL;
+            n = p->pilha[p->inicioFila++];
+            if (n->esq)
+                p->pilha.push_back(n->esq);
+            if (n->dir)
+                p->pilha.push_back(n->dir);
+            return n;
+    }
+    return NULL;
+}
+
+void PulaFilhos(TPercurso* p)
+{
+    if (p->ordem == PERCURSO_PRE)
+        p->anterior = NULL;
+}
+
+// Empilha o caminho ate a menor chave >= lo dentro de "a".
+static void desceIntervalo(TIntervalo* it, pNodoA* a, int lo)
+{
+    while (a != NULL) {
+        if (a->info < lo)
+            a = a->dir;
+        else {
+            it->pilha.push_back(a);
+            a = a->esq;
+        }
+    }
+}
+
+void IniciaIntervalo(TIntervalo* it, pNodoA* raiz, int lo, int hi)
+{
+    it->pilha.clear();
+    it->hi = hi;
+    if (lo <= hi)
+        desceIntervalo(it, raiz, lo);
+}
+
+pNodoA* ProximoIntervalo(TIntervalo* it)
+{
+    if (it->pilha.empty())
+        return NULL;
+    pNodoA* n = it->pilha.back();
+    if (n->info > it->hi) {
+        it->pilha.clear();
+        return NULL;
+    }
+    it->pilha.pop_back();
+    desceIntervalo(it, n->dir, n->info);
+    return n;
+}
@@ -0,0 +1,170 @@
+#include <vertex_normals.h>
+
+#include <cmath>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define NORMAIS_SSE
+#endif
+
+// Menos triangulos que isso por thread nao pagam a criacao dela.
+#define TRIANGULOS_POR_THREAD 16384
+
+// Os acumuladores guardam 4 floats por vertice (x, y, z, 0) para que cada
+// soma seja uma so' instrucao.
+
+static void acumulaTriangulos(const float* p, const int* tri, size_t inicio, size_t fim, float* acum)
+{
+    size_t t = inicio;
+#ifdef NORMAIS_SSE
+    for (; t + 4 <= fim; t += 4)
+    {
+        const int* v = tri + 3*t;
+        // SoA: coordenada x dos 4 triangulos num registrador, e assim por diante
+        __m128 ax = _mm_setr_ps(p[3*v[0]],     p[3*v[3]],     p[3*v[6]],     p[3*v[9]]);
+        __m128 ay = _mm_setr_ps(p[3*v[0] + 1], p[3*v[3] + 1], p[3*v[6] + 1], p[3*v[9] + 1]);
+        __m128 az = _mm_setr_ps(p[3*v[0] + 2], p[3*v[3] + 2], p[3*v[6] + 2], p[3*v[9] + 2]);
+        __m128 ux = _mm_sub_ps(_mm_setr_ps(p[3*v[1]],     p[3*v[4]],     p[3*v[7]],     p[3*v[10]]),     ax);
+        __m128 uy = _mm_sub_ps(_mm_setr_ps(p[3*v[1] + 1], p[3*v[4] + 1], p[3*v[7] + 1], p[3*v[10] + 1]), ay);
+        __m128 uz = _mm_sub_ps(_mm_setr_ps(p[3*v[1] + 2], p[3*v[4] + 2], p[3*v[7] + 2], p[3*v[10] + 2]), az);
+        __m128 wx = _mm_sub_ps(_mm_setr_ps(p[3*v[2]],     p[3*v[5]],     p[3*v[8]],     p[3*v[11]]),     ax);
+        __m128 wy = _mm_sub_ps(_mm_setr_ps(p[3*v[2] + 1], p[3*v[5] + 1], p[3*v[8] + 1], p[3*v[11] + 1]), ay);
+        __m128 wz = _mm_sub_ps(_mm_setr_ps(p[3*v[2] + 2], p[3*v[5] + 2], p[3*v[8] + 2], p[3*v[11] + 2]), az);
+
+        // n = (b - a) x (c - a)
+        __m128 nx = _mm_sub_ps(_mm_mul_ps(uy, wz), _mm_mul_ps(uz, wy));
+        __m128 ny = _mm_sub_ps(_mm_mul_ps(uz, wx), _mm_mul_ps(ux, wz));
+        __m128 nz = _mm_sub_ps(_mm_mul_ps(ux, wy), _mm_mul_ps(uy, wx));
+        __m128 n3 = _mm_setzero_ps();
+        __m128 n0 = nx, n1 = ny, n2 = nz;
+        _MM_TRANSPOSE4_PS(n0, n1, n2, n3);
+        __m128 n[4] = { n0, n1, n2, n3 };
+
+        for (int k = 0; k < 12; k++)
+        {
+            float* a = acum + 4*(size_t) v[k];
+            _mm_storeu_ps(a, _mm_add_ps(_mm_loadu_ps(a), n[k / 3]));
+        }
+    }
+#endif
+    for (; t < fim; t++)
+    {
+        const int* v = tri + 3*t;
+        const float* a = p + 3*v[0];
+        const float* b = p + 3*v[1];
+        const float* c = p + 3*v[2];
+        float ux = b[0] - a[0], uy = b[1] - a[1], uz = b[2] - a[2];
+        float wx = c[0] - a[0], wy = c[1] - a[1], wz = c[2] - a[2];
+        float nx = uy*wz - uz*wy;
+        float ny = uz*wx - ux*wz;
+        float nz = ux*wy - uy*wx;
+        for (int k = 0; k < 3; k++)
+        {
+            float* s = acum + 4*(size_t) v[k];
+            s[0] += nx;
+            s[1] += ny;
+            s[2] += nz;
+        }
+    }
+}
+
+// Soma os acumuladores das outras threads no primeiro e normaliza os
+// vertices [inicio, fim); inicio e' multiplo de 4.
+static void somaENormaliza(std::vector<std::vector<float> >* acumuladores, size_t inicio, size_t fim, float* normais)
+{
+    float* total = (*acumuladores)[0].data();
+    for (size_t k = 1; k < acumuladores->size(); k++)
+    {
+        const float* parcial = (*acumuladores)[k].data();
+        size_t i = 4*inicio;
+#ifdef NORMAIS_SSE
+        for (; i < 4*fim; i += 4)
+            _mm_storeu_ps(total + i, _mm_add_ps(_mm_loadu_ps(total + i), _mm_loadu_ps(parcial + i)));
+#endif
+        for (; i < 4*fim; i++)
+            total[i] += parcial[i];
+    }
+
+    size_t v = inicio;
+#ifdef NORMAIS_SSE
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 um = _mm_set1_ps(1.0f);
+    for (; v + 4 <= fim; v += 4)
+    {
+        __m128 x = _mm_loadu_ps(total + 4*v);
+        __m128 y = _mm_loadu_ps(total + 4*v + 4);
+        __m128 z = _mm_loadu_ps(total + 4*v + 8);
+        __m128 w = _mm_loadu_ps(total + 4*v + 12);
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        __m128 quadrado = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+        // sqrt e divisao exatas (e nao rsqrt) para dar o mesmo que o laco escalar
+        __m128 inverso = _mm_div_ps(um, _mm_sqrt_ps(quadrado));
+        inverso = _mm_and_ps(inverso, _mm_cmpgt_ps(quadrado, zero));
+        x = _mm_mul_ps(x, inverso);
+        y = _mm_mul_ps(y, inverso);
+        z = _mm_mul_ps(z, inverso);
+        w = zero;
+        _MM_TRANSPOSE4_PS(x, y, z, w);
+        float r[16];
+        _mm_storeu_ps(r, x);
+        _mm_storeu_ps(r + 4, y);
+        _mm_storeu_ps(r + 8, z);
+        _mm_storeu_ps(r + 12, w);
+        for (int k = 0; k < 4; k++)
+        {
+            normais[3*(v + k) + 0] = r[4*k + 0];
+            normais[3*(v + k) + 1] = r[4*k + 1];
+            normais[3*(v + k) + 2] = r[4*k + 2];
+        }
+    }
+#endif
+    for (; v < fim; v++)
+    {
+        const float* s = total + 4*v;
+        float quadrado = s[0]*s[0] + s[1]*s[1] + s[2]*s[2];
+        float inverso = quadrado > 0.0f ? 1.0f / std::sqrt(quadrado) : 0.0f;
+        normais[3*v + 0] = s[0] * inverso;
+        normais[3*v + 1] = s[1] * inverso;
+        normais[3*v + 2] = s[2] * inverso;
+    }
+}
+
+void CalculaNormaisVertices(const float* posicoes, size_t numVertices,
+                            const std::vector<int>& triangulos,
+                            std::vector<float>* normais, int numThreads)
+{
+    size_t numTriangulos = triangulos.size() / 3;
+    normais->assign(3*numVertices, 0.0f);
+    if (numVertices == 0)
+        return;
+
+    if (numThreads <= 0)
+        numThreads = (int) std::thread::hardware_concurrency();
+    size_t partes = numTriangulos / TRIANGULOS_POR_THREAD + 1;
+    if (numThreads > 0 && partes > (size_t) numThreads)
+        partes = numThreads;
+
+    std::vector<std::vector<float> > acumuladores(partes, std::vector<float>(4*numVertices, 0.0f));
+    std::vector<std::thread> threads;
+
+    for (size_t i = 1; i < partes; i++)
+        threads.push_back(std::thread(acumulaTriangulos, posicoes, triangulos.data(),
+                                      numTriangulos * i / partes, numTriangulos * (i + 1) / partes,
+                                      acumuladores[i].data()));
+    acumulaTriangulos(posicoes, triangulos.data(), 0, numTriangulos / partes, acumuladores[0].data());
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+    threads.clear();
+
+    // Mesma divisao para a soma, por faixas de vertices alinhadas em 4.
+    for (size_t i = 1; i < partes; i++)
+    {
+        size_t inicio = (numVertices * i / partes) & ~(size_t) 3;
+        size_t fim = i + 1 == partes ? numVertices : (numVertices * (i + 1) / partes) & ~(size_t) 3;
+        threads.push_back(std::thread(somaENormaliza, &acumuladores, inicio, fim, normais->data()));
+    }
+    somaENormaliza(&acumuladores, 0, partes == 1 ? numVertices : (numVertices / partes) & ~(size_t) 3, normais->data());
+    for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+}